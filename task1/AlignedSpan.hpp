@@ -0,0 +1,125 @@
+#pragma once
+
+#include <bit>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+
+#include <Span.hpp>
+
+// A Span whose first element is known to sit on an `alignment`-byte
+// boundary. The promise is checked once, at construction, and then handed
+// to the compiler through std::assume_aligned in Data()/begin(), so loops
+// over the span need neither unaligned loads nor a peeling prologue.
+//
+// Sub-views keep as much of the guarantee as the offset arithmetic allows:
+// prefixes keep it whole, suffixes and subspans at compile-time offsets get
+// the largest power of two dividing both the alignment and the byte offset.
+// AlignedSpan is-a Span, so it can be passed wherever a Span is expected.
+
+namespace detail {
+
+  constexpr std::size_t CommonAlignment(std::size_t alignment, std::size_t offset_bytes) noexcept {
+    if (offset_bytes == 0) {
+      return alignment;
+    }
+    // Lowest set bit of the offset, capped by what we started with.
+    const std::size_t offset_alignment = offset_bytes & (~offset_bytes + 1);
+    return offset_alignment < alignment ? offset_alignment : alignment;
+  }
+
+}
+
+template <class T, std::size_t extent = std::dynamic_extent, std::size_t alignment = 64>
+class AlignedSpan : public Span<T, extent> {
+  static_assert(std::has_single_bit(alignment), "alignment must be a power of two");
+  static_assert(alignment >= alignof(T), "alignment cannot be weaker than alignof(T)");
+
+  using Base = Span<T, extent>;
+
+public:
+  using typename Base::pointer;
+  using typename Base::iterator;
+  using typename Base::reference;
+  using typename Base::size_type;
+
+  static constexpr std::size_t kAlignment = alignment;
+
+  AlignedSpan() requires (extent == 0 || extent == std::dynamic_extent) = default;
+
+  // Anything Span can be built from; the data must actually be aligned.
+  template <class... Args>
+  requires std::constructible_from<Base, Args...> &&
+    (sizeof...(Args) != 1 || !(std::same_as<std::remove_cvref_t<Args>, AlignedSpan> && ...))
+  constexpr explicit AlignedSpan(Args&&... args) : Base(std::forward<Args>(args)...) {
+    assert(IsAligned(Base::Data()));
+  }
+
+  static bool IsAligned(const T* data) noexcept {
+    return reinterpret_cast<std::uintptr_t>(data) % alignment == 0;
+  }
+
+  constexpr pointer Data() const noexcept {
+    return std::assume_aligned<alignment>(Base::Data());
+  }
+
+  constexpr iterator begin() const noexcept {
+    return Data();
+  }
+
+  constexpr iterator end() const noexcept {
+    return Data() + Base::Size();
+  }
+
+  constexpr reference operator[](size_t index) const {
+    assert(index < Base::Size());
+    return Data()[index];
+  }
+
+  template <std::size_t Count>
+  constexpr auto First() const {
+    assert(Count <= Base::Size());
+    return AlignedSpan<T, Count, alignment>(Data(), Count);
+  }
+
+  constexpr auto First(size_t Count) const {
+    assert(Count <= Base::Size());
+    return AlignedSpan<T, std::dynamic_extent, alignment>(Data(), Count);
+  }
+
+  // Where a suffix starts is only known with a static extent; a runtime
+  // Last(count) gives a plain Span.
+  using Base::Last;
+
+  template <std::size_t Count>
+  constexpr auto Last() const {
+    assert(Count <= Base::Size());
+    if constexpr (extent != std::dynamic_extent) {
+      return Subspan<extent - Count, Count>();
+    } else {
+      return AlignedSpan<T, Count, alignof(T)>(Data() + Base::Size() - Count, Count);
+    }
+  }
+
+  template <std::size_t Offset, std::size_t Count = std::dynamic_extent>
+  constexpr auto Subspan() const {
+    assert(Offset <= Base::Size());
+    constexpr std::size_t kept = detail::CommonAlignment(alignment, Offset * sizeof(T));
+    constexpr std::size_t sub_alignment = kept < alignof(T) ? alignof(T) : kept;
+    if constexpr (Count == std::dynamic_extent) {
+      constexpr std::size_t sub_extent =
+        extent == std::dynamic_extent ? std::dynamic_extent : extent - Offset;
+      return AlignedSpan<T, sub_extent, sub_alignment>(Data() + Offset, Base::Size() - Offset);
+    } else {
+      assert(Offset + Count <= Base::Size());
+      return AlignedSpan<T, Count, sub_alignment>(Data() + Offset, Count);
+    }
+  }
+};
+
+template <std::size_t alignment, class T, std::size_t extent>
+AlignedSpan<T, extent, alignment> AssumeAligned(Span<T, extent> span) {
+  return AlignedSpan<T, extent, alignment>(span);
+}
@@ -0,0 +1,238 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <type_traits>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <Span.hpp>
+
+// A file mapped into memory for as long as the object lives. Views over it
+// are plain Spans, so anything that takes a Span works on the file contents
+// without copying them into a buffer first.
+
+enum class MapMode {
+  kReadOnly,
+  kReadWrite,
+};
+
+enum class AccessPattern {
+  kNormal,
+  kSequential,
+  kRandom,
+  kWillNeed,
+  kDontNeed,
+};
+
+struct MapOptions {
+  MapMode mode = MapMode::kReadOnly;
+  AccessPattern pattern = AccessPattern::kNormal;
+  // Ask for transparent huge pages; silently ignored where unsupported.
+  bool huge_pages = false;
+  // Fault every page in up front instead of on first touch.
+  bool populate = false;
+};
+
+namespace detail {
+
+  [[noreturn]] inline void ThrowErrno(const std::string& what) {
+    throw std::system_error(errno, std::generic_category(), what);
+  }
+
+  inline int ToMadvise(AccessPattern pattern) noexcept {
+    switch (pattern) {
+      case AccessPattern::kSequential:
+        return MADV_SEQUENTIAL;
+      case AccessPattern::kRandom:
+        return MADV_RANDOM;
+      case AccessPattern::kWillNeed:
+        return MADV_WILLNEED;
+      case AccessPattern::kDontNeed:
+        return MADV_DONTNEED;
+      default:
+        return MADV_NORMAL;
+    }
+  }
+
+}
+
+class MappedFile {
+public:
+  MappedFile() = default;
+
+  explicit MappedFile(const std::string& path, MapOptions options = {})
+    : writable_(options.mode == MapMode::kReadWrite)
+  {
+    const int fd = ::open(path.c_str(), writable_ ? O_RDWR : O_RDONLY);
+    if (fd < 0) {
+      detail::ThrowErrno("open " + path);
+    }
+    struct stat info {};
+    if (::fstat(fd, &info) != 0) {
+      ::close(fd);
+      detail::ThrowErrno("fstat " + path);
+    }
+    size_ = static_cast<std::size_t>(info.st_size);
+    if (size_ == 0) {
+      // mmap rejects empty ranges; an empty file is just an empty view.
+      ::close(fd);
+      return;
+    }
+
+    int flags = MAP_SHARED;
+#ifdef MAP_POPULATE
+    if (options.populate) {
+      flags |= MAP_POPULATE;
+    }
+#endif
+    void* addr = ::mmap(nullptr, size_, writable_ ? PROT_READ | PROT_WRITE : PROT_READ, flags, fd, 0);
+    // The mapping keeps its own reference to the file.
+    ::close(fd);
+    if (addr == MAP_FAILED) {
+      detail::ThrowErrno("mmap " + path);
+    }
+    data_ = static_cast<std::byte*>(addr);
+
+#ifdef MADV_HUGEPAGE
+    if (options.huge_pages) {
+      ::madvise(data_, size_, MADV_HUGEPAGE);
+    }
+#endif
+    if (options.pattern != AccessPattern::kNormal) {
+      // No destructor runs for a constructor that throws.
+      try {
+        Advise(options.pattern);
+      } catch (...) {
+        Unmap();
+        throw;
+      }
+    }
+  }
+
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+
+  MappedFile(MappedFile&& other) noexcept
+    : data_(std::exchange(other.data_, nullptr))
+    , size_(std::exchange(other.size_, 0))
+    , writable_(std::exchange(other.writable_, false))
+  {}
+
+  MappedFile& operator=(MappedFile&& other) noexcept {
+    if (this != &other) {
+      Unmap();
+      data_ = std::exchange(other.data_, nullptr);
+      size_ = std::exchange(other.size_, 0);
+      writable_ = std::exchange(other.writable_, false);
+    }
+    return *this;
+  }
+
+  ~MappedFile() {
+    Unmap();
+  }
+
+  std::size_t Size() const noexcept {
+    return size_;
+  }
+
+  bool Empty() const noexcept {
+    return size_ == 0;
+  }
+
+  bool Writable() const noexcept {
+    return writable_;
+  }
+
+  Span<const std::byte> Bytes() const noexcept {
+    return Span<const std::byte>(static_cast<const std::byte*>(data_), size_);
+  }
+
+  Span<std::byte> MutableBytes() const {
+    RequireWritable();
+    return Span<std::byte>(data_, size_);
+  }
+
+  // Hint the kernel about the access pattern of [offset, offset + length).
+  // The range is widened to whole pages.
+  void Advise(AccessPattern pattern, std::size_t offset = 0,
+              std::size_t length = std::dynamic_extent) const {
+    if (size_ == 0) {
+      return;
+    }
+    assert(offset <= size_);
+    length = std::min(length, size_ - offset);
+    const std::size_t page = static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+    const std::size_t begin = offset - offset % page;
+    if (::madvise(data_ + begin, offset + length - begin, detail::ToMadvise(pattern)) != 0) {
+      detail::ThrowErrno("madvise");
+    }
+  }
+
+  // Views `count` records starting at byte `offset`; by default everything
+  // from `offset` to the end of the file, which must then hold whole records.
+  template <class Record>
+  requires std::is_trivially_copyable_v<std::remove_const_t<Record>>
+  Span<const Record> As(std::size_t offset = 0, std::size_t count = std::dynamic_extent) const {
+    return View<const Record>(offset, count);
+  }
+
+  template <class Record>
+  requires std::is_trivially_copyable_v<Record>
+  Span<Record> MutableAs(std::size_t offset = 0, std::size_t count = std::dynamic_extent) const {
+    RequireWritable();
+    return View<Record>(offset, count);
+  }
+
+private:
+  // Writes through a read-only mapping fault, so refuse to hand them out.
+  void RequireWritable() const {
+    if (!writable_) {
+      throw std::logic_error("MappedFile: the file is mapped read-only");
+    }
+  }
+
+  template <class Record>
+  Span<Record> View(std::size_t offset, std::size_t count) const {
+    if (offset > size_) {
+      throw std::out_of_range("MappedFile: offset past the end of the file");
+    }
+    const std::size_t available = size_ - offset;
+    if (count == std::dynamic_extent) {
+      if (available % sizeof(Record) != 0) {
+        throw std::invalid_argument("MappedFile: file does not hold a whole number of records");
+      }
+      count = available / sizeof(Record);
+    } else if (count > available / sizeof(Record)) {
+      throw std::out_of_range("MappedFile: record range past the end of the file");
+    }
+    std::byte* first = data_ + offset;
+    if (count != 0 && reinterpret_cast<std::uintptr_t>(first) % alignof(Record) != 0) {
+      throw std::invalid_argument("MappedFile: records are not suitably aligned");
+    }
+    return Span<Record>(reinterpret_cast<Record*>(first), count);
+  }
+
+  void Unmap() noexcept {
+    if (data_ != nullptr) {
+      ::munmap(data_, size_);
+      data_ = nullptr;
+      size_ = 0;
+    }
+  }
+
+  std::byte* data_ = nullptr;
+  std::size_t size_ = 0;
+  bool writable_ = false;
+};
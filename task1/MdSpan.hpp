@@ -0,0 +1,358 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <concepts>
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+
+#include <Span.hpp>
+
+// A multi-dimensional view over a flat buffer. Each extent is static or
+// std::dynamic_extent, exactly like Span's, and is stored through the same
+// detail::SpanSize: a fully static MdSpan is a single pointer.
+
+namespace detail {
+
+  // SpanSize lets a Span view a prefix of a static extent; an extent of an
+  // MdSpan has to be exactly the static one, or indexing would assume rows
+  // and planes that the buffer does not have.
+  template <std::size_t index, std::size_t extent>
+  struct ExtentSlot : SpanSize<extent> {
+    ExtentSlot(std::size_t size) : SpanSize<extent>(size) {
+      assert(extent == std::dynamic_extent || size == extent);
+    }
+
+    constexpr std::size_t Get() const noexcept {
+      if constexpr (extent == std::dynamic_extent) {
+        return this->size_;
+      } else {
+        return extent;
+      }
+    }
+  };
+
+  template <class Indices, std::size_t... extents>
+  struct ExtentsStorage;
+
+  template <std::size_t... I, std::size_t... extents>
+  struct ExtentsStorage<std::index_sequence<I...>, extents...> : ExtentSlot<I, extents>... {
+    ExtentsStorage(const std::array<std::size_t, sizeof...(I)>& sizes)
+      : ExtentSlot<I, extents>(sizes[I])... {}
+  };
+
+}
+
+template <std::size_t... extents>
+class Extents
+  : private detail::ExtentsStorage<std::make_index_sequence<sizeof...(extents)>, extents...> {
+  using Storage = detail::ExtentsStorage<std::make_index_sequence<sizeof...(extents)>, extents...>;
+
+public:
+  static constexpr std::size_t kRank = sizeof...(extents);
+  static constexpr std::size_t kDynamicRank = ((extents == std::dynamic_extent) + ... + 0);
+  static constexpr std::array<std::size_t, kRank> kStatic{extents...};
+
+  // Either every extent, or only the dynamic ones in order.
+  template <std::convertible_to<std::size_t>... Sizes>
+  requires (sizeof...(Sizes) == kRank || sizeof...(Sizes) == kDynamicRank)
+  explicit(sizeof...(Sizes) != 0) Extents(Sizes... sizes)
+    : Storage(Expand(std::array<std::size_t, sizeof...(Sizes)>{static_cast<std::size_t>(sizes)...})) {}
+
+  explicit Extents(const std::array<std::size_t, kRank>& sizes) : Storage(sizes) {}
+
+  template <std::size_t I>
+  constexpr std::size_t Extent() const noexcept {
+    return static_cast<const detail::ExtentSlot<I, kStatic[I]>&>(*this).Get();
+  }
+
+  constexpr std::size_t Extent(std::size_t i) const noexcept {
+    assert(i < kRank);
+    return [&]<std::size_t... I>(std::index_sequence<I...>) {
+      std::size_t result = 0;
+      ((i == I ? (result = Extent<I>()) : 0), ...);
+      return result;
+    }(std::make_index_sequence<kRank>{});
+  }
+
+  constexpr std::size_t Size() const noexcept {
+    return [&]<std::size_t... I>(std::index_sequence<I...>) {
+      return (std::size_t{1} * ... * Extent<I>());
+    }(std::make_index_sequence<kRank>{});
+  }
+
+  // Product of the extents when all of them are static.
+  static constexpr std::size_t kStaticSize =
+    kDynamicRank == 0 ? (std::size_t{1} * ... * extents) : std::dynamic_extent;
+
+private:
+  template <std::size_t count>
+  static std::array<std::size_t, kRank> Expand(const std::array<std::size_t, count>& sizes) {
+    if constexpr (count == kRank) {
+      return sizes;
+    } else {
+      std::array<std::size_t, kRank> all{};
+      std::size_t next = 0;
+      for (std::size_t i = 0; i < kRank; ++i) {
+        all[i] = kStatic[i] == std::dynamic_extent ? sizes[next++] : kStatic[i];
+      }
+      return all;
+    }
+  }
+};
+
+namespace detail {
+
+  template <class Indices>
+  struct DynamicExtentsImpl;
+
+  template <std::size_t... I>
+  struct DynamicExtentsImpl<std::index_sequence<I...>> {
+    using Type = Extents<(static_cast<void>(I), std::dynamic_extent)...>;
+  };
+
+}
+
+template <std::size_t rank>
+using DynamicExtents = typename detail::DynamicExtentsImpl<std::make_index_sequence<rank>>::Type;
+
+// Last index varies fastest.
+struct LayoutRowMajor {
+  template <class Ext, class... Index>
+  static constexpr std::size_t Offset(const Ext& ext, Index... index) noexcept {
+    const std::array<std::size_t, sizeof...(Index)> at{static_cast<std::size_t>(index)...};
+    return [&]<std::size_t... I>(std::index_sequence<I...>) {
+      std::size_t offset = 0;
+      ((offset = offset * ext.template Extent<I>() + at[I]), ...);
+      return offset;
+    }(std::make_index_sequence<sizeof...(Index)>{});
+  }
+};
+
+// First index varies fastest.
+struct LayoutColumnMajor {
+  template <class Ext, class... Index>
+  static constexpr std::size_t Offset(const Ext& ext, Index... index) noexcept {
+    constexpr std::size_t rank = sizeof...(Index);
+    const std::array<std::size_t, rank> at{static_cast<std::size_t>(index)...};
+    return [&]<std::size_t... I>(std::index_sequence<I...>) {
+      std::size_t offset = 0;
+      ((offset = offset * ext.template Extent<rank - 1 - I>() + at[rank - 1 - I]), ...);
+      return offset;
+    }(std::make_index_sequence<rank>{});
+  }
+};
+
+// 2D only: the matrix is cut into tile_rows x tile_cols tiles stored one
+// after another in row-major order, each tile row-major inside. Both extents
+// must be multiples of the tile shape.
+template <std::size_t tile_rows, std::size_t tile_cols>
+struct LayoutTiled {
+  static_assert(tile_rows > 0 && tile_cols > 0);
+
+  static constexpr std::size_t kTileRows = tile_rows;
+  static constexpr std::size_t kTileCols = tile_cols;
+
+  template <class Ext>
+  static constexpr std::size_t Offset(const Ext& ext, std::size_t row, std::size_t col) noexcept {
+    static_assert(Ext::kRank == 2, "LayoutTiled is two-dimensional");
+    const std::size_t tiles_per_row = ext.template Extent<1>() / tile_cols;
+    const std::size_t tile = (row / tile_rows) * tiles_per_row + col / tile_cols;
+    return tile * (tile_rows * tile_cols) + (row % tile_rows) * tile_cols + col % tile_cols;
+  }
+};
+
+template <class T, class Ext, class Layout = LayoutRowMajor>
+class MdSpan {
+public:
+  using element_type = T;
+  using extents_type = Ext;
+  using layout_type = Layout;
+  using pointer = T*;
+  using reference = T&;
+
+  static constexpr std::size_t kRank = Ext::kRank;
+
+  MdSpan() requires (Ext::kDynamicRank == Ext::kRank) : extents_(std::array<std::size_t, kRank>{}) {}
+
+  MdSpan(pointer data, const Ext& extents) : data_(data), extents_(extents) {
+    CheckTiling();
+  }
+
+  // Sizes as accepted by Ext: all of them or just the dynamic ones.
+  template <std::convertible_to<std::size_t>... Sizes>
+  requires std::constructible_from<Ext, Sizes...>
+  explicit MdSpan(pointer data, Sizes... sizes) : data_(data), extents_(sizes...) {
+    CheckTiling();
+  }
+
+  template <std::convertible_to<std::size_t>... Index>
+  requires (sizeof...(Index) == kRank)
+  constexpr reference operator()(Index... index) const {
+    assert(InBounds(static_cast<std::size_t>(index)...));
+    return data_[Layout::Offset(extents_, index...)];
+  }
+
+  constexpr const Ext& Extents() const noexcept {
+    return extents_;
+  }
+
+  template <std::size_t I>
+  constexpr std::size_t Extent() const noexcept {
+    return extents_.template Extent<I>();
+  }
+
+  constexpr std::size_t Extent(std::size_t i) const noexcept {
+    return extents_.Extent(i);
+  }
+
+  constexpr std::size_t Size() const noexcept {
+    return extents_.Size();
+  }
+
+  constexpr pointer Data() const noexcept {
+    return data_;
+  }
+
+  // The underlying buffer in storage order.
+  constexpr auto Flat() const {
+    return Span<T, Ext::kStaticSize>(data_, Size());
+  }
+
+  // A whole row; contiguous only in row-major storage.
+  constexpr auto Row(std::size_t row) const
+  requires (kRank == 2 && std::same_as<Layout, LayoutRowMajor>)
+  {
+    assert(row < Extent<0>());
+    return Span<T, Ext::kStatic[1]>(data_ + row * Extent<1>(), Extent<1>());
+  }
+
+  // A whole column; contiguous only in column-major storage.
+  constexpr auto Column(std::size_t col) const
+  requires (kRank == 2 && std::same_as<Layout, LayoutColumnMajor>)
+  {
+    assert(col < Extent<1>());
+    return Span<T, Ext::kStatic[0]>(data_ + col * Extent<0>(), Extent<0>());
+  }
+
+private:
+  template <class... Index>
+  constexpr bool InBounds(Index... index) const noexcept {
+    std::size_t dim = 0;
+    return ((index < extents_.Extent(dim++)) && ...);
+  }
+
+  void CheckTiling() const noexcept {
+    if constexpr (requires { Layout::kTileRows; }) {
+      assert(Extent<0>() % Layout::kTileRows == 0 && Extent<1>() % Layout::kTileCols == 0);
+    }
+  }
+
+  pointer data_ = nullptr;
+  [[no_unique_address]] Ext extents_;
+};
+
+template <class T, std::size_t rows = std::dynamic_extent, std::size_t cols = std::dynamic_extent,
+          class Layout = LayoutRowMajor>
+using Span2D = MdSpan<T, Extents<rows, cols>, Layout>;
+
+// Cache-blocked traversal of 2D views.
+
+inline constexpr std::size_t kL1CacheBytes = 32 * 1024;
+inline constexpr std::size_t kL2CacheBytes = 1024 * 1024;
+
+struct TileShape {
+  std::size_t rows;
+  std::size_t cols;
+};
+
+// Largest power-of-two square tile of T whose footprint is at most half of
+// `cache_bytes`, leaving the other half for whatever the loop writes to.
+template <class T>
+constexpr TileShape CacheTile(std::size_t cache_bytes) noexcept {
+  std::size_t side = 1;
+  while ((2 * side) * (2 * side) * sizeof(T) <= cache_bytes / 2) {
+    side *= 2;
+  }
+  return {side, side};
+}
+
+namespace detail {
+
+  // Tiles of [r0, r1) x [c0, c1), ordered along the storage order of Layout.
+  template <class Layout, class F>
+  void TileLoop(std::size_t r0, std::size_t r1, std::size_t c0, std::size_t c1, TileShape tile, F& fn) {
+    if constexpr (std::same_as<Layout, LayoutColumnMajor>) {
+      for (std::size_t c = c0; c < c1; c += tile.cols) {
+        for (std::size_t r = r0; r < r1; r += tile.rows) {
+          fn(r, std::min(r + tile.rows, r1), c, std::min(c + tile.cols, c1));
+        }
+      }
+    } else {
+      for (std::size_t r = r0; r < r1; r += tile.rows) {
+        for (std::size_t c = c0; c < c1; c += tile.cols) {
+          fn(r, std::min(r + tile.rows, r1), c, std::min(c + tile.cols, c1));
+        }
+      }
+    }
+  }
+
+  template <class T, class Ext, class Layout, class F>
+  void VisitTile(const MdSpan<T, Ext, Layout>& view, std::size_t r0, std::size_t r1,
+                 std::size_t c0, std::size_t c1, F& fn) {
+    if constexpr (std::same_as<Layout, LayoutColumnMajor>) {
+      for (std::size_t c = c0; c < c1; ++c) {
+        for (std::size_t r = r0; r < r1; ++r) {
+          fn(r, c, view(r, c));
+        }
+      }
+    } else {
+      for (std::size_t r = r0; r < r1; ++r) {
+        for (std::size_t c = c0; c < c1; ++c) {
+          fn(r, c, view(r, c));
+        }
+      }
+    }
+  }
+
+}
+
+// fn(row_begin, row_end, col_begin, col_end) for every tile covering the
+// view, tiles ordered along the storage order of the layout.
+template <class T, class Ext, class Layout, class F>
+requires (Ext::kRank == 2)
+void ForEachTile(const MdSpan<T, Ext, Layout>& view, TileShape tile, F&& fn) {
+  assert(tile.rows > 0 && tile.cols > 0);
+  detail::TileLoop<Layout>(0, view.template Extent<0>(), 0, view.template Extent<1>(), tile, fn);
+}
+
+// fn(row, col, element) for every element, walking L2-sized tiles split into
+// L1-sized ones, so accesses that go against the storage order (the other
+// side of a transpose, a column sweep) stay within cache. Tiled layouts walk
+// their own tiles; views small enough for L1 are walked directly.
+template <class T, class Ext, class Layout, class F>
+requires (Ext::kRank == 2)
+void ForEachBlocked(const MdSpan<T, Ext, Layout>& view, F&& fn) {
+  const std::size_t rows = view.template Extent<0>();
+  const std::size_t cols = view.template Extent<1>();
+  if constexpr (Ext::kStaticSize != std::dynamic_extent && Ext::kStaticSize * sizeof(T) <= kL1CacheBytes) {
+    detail::VisitTile(view, 0, rows, 0, cols, fn);
+  } else if constexpr (requires { Layout::kTileRows; }) {
+    auto visit = [&](std::size_t r0, std::size_t r1, std::size_t c0, std::size_t c1) {
+      detail::VisitTile(view, r0, r1, c0, c1, fn);
+    };
+    detail::TileLoop<Layout>(0, rows, 0, cols, TileShape{Layout::kTileRows, Layout::kTileCols}, visit);
+  } else {
+    constexpr TileShape l1 = CacheTile<T>(kL1CacheBytes);
+    constexpr TileShape l2 = CacheTile<T>(kL2CacheBytes);
+    auto visit = [&](std::size_t r0, std::size_t r1, std::size_t c0, std::size_t c1) {
+      detail::VisitTile(view, r0, r1, c0, c1, fn);
+    };
+    auto split = [&](std::size_t r0, std::size_t r1, std::size_t c0, std::size_t c1) {
+      detail::TileLoop<Layout>(r0, r1, c0, c1, l1, visit);
+    };
+    detail::TileLoop<Layout>(0, rows, 0, cols, l2, split);
+  }
+}
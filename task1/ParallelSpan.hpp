@@ -0,0 +1,279 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <concepts>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <Span.hpp>
+
+// A small work-stealing pool and ParallelFor / ParallelReduce over Span.
+//
+// Every worker owns a deque: it pushes and pops its own tasks at the back and,
+// when it runs dry, steals from the front of the others. Threads that wait for
+// a parallel loop to finish run queued tasks instead of blocking, so loops may
+// be nested freely.
+
+class WorkStealingPool {
+public:
+  using Task = std::function<void()>;
+
+  explicit WorkStealingPool(std::size_t threads = DefaultConcurrency())
+    : queues_(std::max<std::size_t>(threads, 1))
+  {
+    workers_.reserve(queues_.size());
+    for (std::size_t i = 0; i < queues_.size(); ++i) {
+      workers_.emplace_back([this, i] { WorkerLoop(i); });
+    }
+  }
+
+  WorkStealingPool(const WorkStealingPool&) = delete;
+  WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+  ~WorkStealingPool() {
+    {
+      std::lock_guard lock(sleep_mutex_);
+      stopping_ = true;
+    }
+    wake_.notify_all();
+    for (auto& worker : workers_) {
+      worker.join();
+    }
+  }
+
+  static std::size_t DefaultConcurrency() noexcept {
+    return std::max(1u, std::thread::hardware_concurrency());
+  }
+
+  // Process-wide pool sized to the hardware.
+  static WorkStealingPool& Default() {
+    static WorkStealingPool pool;
+    return pool;
+  }
+
+  std::size_t Concurrency() const noexcept {
+    return queues_.size();
+  }
+
+  // Workers push to their own deque; other threads spread tasks round-robin.
+  void Submit(Task task) {
+    const std::size_t target =
+      CurrentPool() == this ? CurrentIndex() : next_queue_.fetch_add(1, std::memory_order_relaxed) % queues_.size();
+    // Counted before it becomes visible so Take never drives pending_ below zero.
+    pending_.fetch_add(1, std::memory_order_release);
+    {
+      std::lock_guard lock(queues_[target].mutex);
+      queues_[target].tasks.push_back(std::move(task));
+    }
+    {
+      // Pairs with the predicate check in WorkerLoop so a wake-up is never lost.
+      std::lock_guard lock(sleep_mutex_);
+    }
+    wake_.notify_one();
+  }
+
+  // Runs one queued task on the calling thread; false if there was none.
+  bool TryRunOne() {
+    const std::size_t home = CurrentPool() == this ? CurrentIndex() : 0;
+    if (auto task = Take(home)) {
+      (*task)();
+      return true;
+    }
+    return false;
+  }
+
+private:
+  struct Queue {
+    std::mutex mutex;
+    std::deque<Task> tasks;
+  };
+
+  static const WorkStealingPool*& CurrentPool() noexcept {
+    thread_local const WorkStealingPool* pool = nullptr;
+    return pool;
+  }
+
+  static std::size_t& CurrentIndex() noexcept {
+    thread_local std::size_t index = 0;
+    return index;
+  }
+
+  std::optional<Task> Take(std::size_t home) {
+    {
+      auto& own = queues_[home];
+      std::lock_guard lock(own.mutex);
+      if (!own.tasks.empty()) {
+        Task task = std::move(own.tasks.back());
+        own.tasks.pop_back();
+        pending_.fetch_sub(1, std::memory_order_relaxed);
+        return task;
+      }
+    }
+    for (std::size_t step = 1; step < queues_.size(); ++step) {
+      auto& victim = queues_[(home + step) % queues_.size()];
+      std::unique_lock lock(victim.mutex, std::try_to_lock);
+      if (lock.owns_lock() && !victim.tasks.empty()) {
+        Task task = std::move(victim.tasks.front());
+        victim.tasks.pop_front();
+        pending_.fetch_sub(1, std::memory_order_relaxed);
+        return task;
+      }
+    }
+    return std::nullopt;
+  }
+
+  void WorkerLoop(std::size_t index) {
+    CurrentPool() = this;
+    CurrentIndex() = index;
+    while (true) {
+      if (auto task = Take(index)) {
+        (*task)();
+        continue;
+      }
+      std::unique_lock lock(sleep_mutex_);
+      wake_.wait(lock, [this] {
+        return stopping_ || pending_.load(std::memory_order_acquire) > 0;
+      });
+      if (stopping_ && pending_.load(std::memory_order_acquire) == 0) {
+        return;
+      }
+    }
+  }
+
+  std::vector<Queue> queues_;
+  std::vector<std::thread> workers_;
+  std::atomic<std::size_t> pending_{0};
+  std::atomic<std::size_t> next_queue_{0};
+  std::mutex sleep_mutex_;
+  std::condition_variable wake_;
+  bool stopping_ = false;
+};
+
+namespace detail {
+
+  // Enough chunks to keep every thread busy while letting stealing even out
+  // uneven per-element cost, but none smaller than `min_grain` elements.
+  inline std::size_t ParallelGrain(std::size_t size, std::size_t threads, std::size_t min_grain) {
+    const std::size_t target_chunks = threads * 4;
+    return std::max({min_grain, (size + target_chunks - 1) / target_chunks, std::size_t{1}});
+  }
+
+  // Runs body(i) for every i in [0, count) on the pool and waits, helping out
+  // in the meantime. The first exception thrown by a body is rethrown here.
+  template <class Body>
+  void ParallelInvoke(WorkStealingPool& pool, std::size_t count, Body& body) {
+    if (count == 0) {
+      return;
+    }
+    struct State {
+      std::atomic<std::size_t> remaining;
+      std::atomic<bool> failed{false};
+      std::exception_ptr error;
+    };
+    auto state = std::make_shared<State>();
+    state->remaining.store(count, std::memory_order_relaxed);
+
+    auto run = [state, &body](std::size_t i) {
+      if (!state->failed.load(std::memory_order_relaxed)) {
+        try {
+          body(i);
+        } catch (...) {
+          if (!state->failed.exchange(true)) {
+            state->error = std::current_exception();
+          }
+        }
+      }
+      state->remaining.fetch_sub(1, std::memory_order_acq_rel);
+    };
+
+    // The calling thread takes the first piece itself.
+    for (std::size_t i = 1; i < count; ++i) {
+      pool.Submit([run, i] { run(i); });
+    }
+    run(0);
+
+    while (state->remaining.load(std::memory_order_acquire) != 0) {
+      if (!pool.TryRunOne()) {
+        std::this_thread::yield();
+      }
+    }
+    if (state->error) {
+      std::rethrow_exception(state->error);
+    }
+  }
+
+}
+
+// fn(element) for every element of span, spread over the pool.
+template <class T, std::size_t extent, class F>
+requires std::invocable<F&, T&>
+void ParallelFor(Span<T, extent> span, F fn, std::size_t min_grain = 1024,
+                 WorkStealingPool& pool = WorkStealingPool::Default()) {
+  const auto chunks = span.Chunks(detail::ParallelGrain(span.Size(), pool.Concurrency(), min_grain));
+  auto body = [&](std::size_t i) {
+    for (T& element : chunks[i]) {
+      fn(element);
+    }
+  };
+  detail::ParallelInvoke(pool, chunks.Size(), body);
+}
+
+// Folds span with op, which must be associative and closed over the
+// element type: op(acc, element) inside a chunk and op(acc, acc) when
+// partial results are combined, with each chunk seeded by its first
+// element. init is folded in exactly once, in front of everything else.
+template <class T, std::size_t extent, class R, class Op>
+requires std::same_as<R, std::remove_cv_t<T>> && std::invocable<Op&, R, T&> && std::invocable<Op&, R, R>
+R ParallelReduce(Span<T, extent> span, R init, Op op, std::size_t min_grain = 1024,
+                 WorkStealingPool& pool = WorkStealingPool::Default()) {
+  const auto chunks = span.Chunks(detail::ParallelGrain(span.Size(), pool.Concurrency(), min_grain));
+  std::vector<std::optional<R>> partial(chunks.Size());
+  auto body = [&](std::size_t i) {
+    auto chunk = chunks[i];
+    R acc = chunk.Front();
+    for (std::size_t j = 1; j < chunk.Size(); ++j) {
+      acc = op(std::move(acc), chunk[j]);
+    }
+    partial[i].emplace(std::move(acc));
+  };
+  detail::ParallelInvoke(pool, chunks.Size(), body);
+  for (auto& value : partial) {
+    init = op(std::move(init), std::move(*value));
+  }
+  return init;
+}
+
+// The general form, for an accumulator of another type than the elements:
+// every chunk is folded with op(acc, element) starting from identity, and
+// the partial results are merged with combine(acc, acc), again starting
+// from identity. identity must be neutral for combine.
+template <class T, std::size_t extent, class R, class Op, class Combine>
+requires std::invocable<Op&, R, T&> && std::invocable<Combine&, R, R>
+R ParallelReduce(Span<T, extent> span, R identity, Op op, Combine combine, std::size_t min_grain = 1024,
+                 WorkStealingPool& pool = WorkStealingPool::Default()) {
+  const auto chunks = span.Chunks(detail::ParallelGrain(span.Size(), pool.Concurrency(), min_grain));
+  std::vector<std::optional<R>> partial(chunks.Size());
+  auto body = [&](std::size_t i) {
+    R acc = identity;
+    for (T& element : chunks[i]) {
+      acc = op(std::move(acc), element);
+    }
+    partial[i].emplace(std::move(acc));
+  };
+  detail::ParallelInvoke(pool, chunks.Size(), body);
+  for (auto& value : partial) {
+    identity = combine(std::move(identity), std::move(*value));
+  }
+  return identity;
+}
@@ -0,0 +1,362 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <compare>
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <ranges>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include <AlignedSpan.hpp>
+#include <Span.hpp>
+#include <type_tuples.hpp>
+
+// A growable table of records stored column by column: one contiguous
+// array per field type of the TTuple, all carved out of a single
+// allocation. Every column starts on a kAlignment-byte boundary, so
+// Column<I>() hands out an AlignedSpan and column scans run over plain
+// contiguous memory. operator[] and the iterators give record-style access
+// through a proxy that refers to the row without copying it.
+
+template <class TT, std::size_t alignment = 64>
+class SoAVector;
+
+namespace detail {
+
+  // A row of an SoAVector (or of a const one): Get<I>() is a reference into
+  // column I. Structured bindings bind to those references.
+  template <class Owner>
+  class SoARowRef {
+  public:
+    SoARowRef(Owner* owner, std::size_t index) : owner_(owner), index_(index) {}
+
+    template <std::size_t I>
+    decltype(auto) Get() const {
+      return owner_->template Column<I>()[index_];
+    }
+
+    template <std::size_t I>
+    friend decltype(auto) get(const SoARowRef& row) {
+      return row.template Get<I>();
+    }
+
+    std::size_t Index() const noexcept {
+      return index_;
+    }
+
+  private:
+    Owner* owner_;
+    std::size_t index_;
+  };
+
+}
+
+template <class Owner>
+struct std::tuple_size<detail::SoARowRef<Owner>>
+  : std::integral_constant<std::size_t, std::remove_const_t<Owner>::kColumns> {};
+
+template <std::size_t I, class Owner>
+struct std::tuple_element<I, detail::SoARowRef<Owner>> {
+  using type = decltype(std::declval<const detail::SoARowRef<Owner>&>().template Get<I>());
+};
+
+template <class... Ts, std::size_t alignment>
+class SoAVector<type_tuples::TTuple<Ts...>, alignment> {
+  static_assert(sizeof...(Ts) > 0, "a record needs at least one field");
+  static_assert((std::is_nothrow_move_constructible_v<Ts> && ...),
+    "columns are relocated on growth and must not throw while moving");
+
+  template <std::size_t I>
+  using Field = type_tuples::Get<I, type_tuples::TTuple<Ts...>>;
+
+  template <class F>
+  static void ForEachColumn(F&& f) {
+    [&]<std::size_t... Is>(std::index_sequence<Is...>) {
+      (f(std::integral_constant<std::size_t, Is>{}), ...);
+    }(std::index_sequence_for<Ts...>{});
+  }
+
+public:
+  static constexpr std::size_t kAlignment = alignment;
+  static constexpr std::size_t kColumns = sizeof...(Ts);
+
+  using Row = detail::SoARowRef<SoAVector>;
+  using ConstRow = detail::SoARowRef<const SoAVector>;
+
+  template <bool is_const>
+  class RowIterator {
+    using Owner = std::conditional_t<is_const, const SoAVector, SoAVector>;
+
+  public:
+    using iterator_category = std::random_access_iterator_tag;
+    using value_type = detail::SoARowRef<Owner>;
+    using difference_type = std::ptrdiff_t;
+
+    RowIterator() = default;
+    RowIterator(Owner* owner, std::size_t index) : owner_(owner), index_(index) {}
+
+    value_type operator*() const { return value_type(owner_, index_); }
+    value_type operator[](difference_type n) const { return value_type(owner_, index_ + n); }
+
+    RowIterator& operator++() { ++index_; return *this; }
+    RowIterator operator++(int) { auto copy = *this; ++index_; return copy; }
+    RowIterator& operator--() { --index_; return *this; }
+    RowIterator operator--(int) { auto copy = *this; --index_; return copy; }
+    RowIterator& operator+=(difference_type n) { index_ += n; return *this; }
+    RowIterator& operator-=(difference_type n) { index_ -= n; return *this; }
+    friend RowIterator operator+(RowIterator it, difference_type n) { return it += n; }
+    friend RowIterator operator+(difference_type n, RowIterator it) { return it += n; }
+    friend RowIterator operator-(RowIterator it, difference_type n) { return it -= n; }
+    friend difference_type operator-(const RowIterator& lhs, const RowIterator& rhs) {
+      return static_cast<difference_type>(lhs.index_) - static_cast<difference_type>(rhs.index_);
+    }
+    friend bool operator==(const RowIterator& lhs, const RowIterator& rhs) { return lhs.index_ == rhs.index_; }
+    friend auto operator<=>(const RowIterator& lhs, const RowIterator& rhs) { return lhs.index_ <=> rhs.index_; }
+
+  private:
+    Owner* owner_ = nullptr;
+    std::size_t index_ = 0;
+  };
+
+  using iterator = RowIterator<false>;
+  using const_iterator = RowIterator<true>;
+
+  SoAVector() = default;
+
+  // Append() cleans up after a throwing copy, so nothing leaks here.
+  SoAVector(const SoAVector& other) {
+    [&]<std::size_t... Is>(std::index_sequence<Is...>) {
+      Append(other.template Column<Is>()...);
+    }(std::index_sequence_for<Ts...>{});
+  }
+
+  SoAVector(SoAVector&& other) noexcept
+    : block_(std::exchange(other.block_, nullptr)),
+      columns_(std::exchange(other.columns_, {})),
+      size_(std::exchange(other.size_, 0)),
+      capacity_(std::exchange(other.capacity_, 0)) {}
+
+  SoAVector& operator=(SoAVector other) noexcept {
+    std::swap(block_, other.block_);
+    std::swap(columns_, other.columns_);
+    std::swap(size_, other.size_);
+    std::swap(capacity_, other.capacity_);
+    return *this;
+  }
+
+  ~SoAVector() {
+    Clear();
+    Deallocate(block_);
+  }
+
+  std::size_t Size() const noexcept {
+    return size_;
+  }
+
+  std::size_t Capacity() const noexcept {
+    return capacity_;
+  }
+
+  bool Empty() const noexcept {
+    return size_ == 0;
+  }
+
+  template <std::size_t I>
+  AlignedSpan<Field<I>, std::dynamic_extent, alignment> Column() {
+    return AlignedSpan<Field<I>, std::dynamic_extent, alignment>(ColumnData<I>(), size_);
+  }
+
+  template <std::size_t I>
+  AlignedSpan<const Field<I>, std::dynamic_extent, alignment> Column() const {
+    return AlignedSpan<const Field<I>, std::dynamic_extent, alignment>(ColumnData<I>(), size_);
+  }
+
+  Row operator[](std::size_t index) {
+    assert(index < size_);
+    return Row(this, index);
+  }
+
+  ConstRow operator[](std::size_t index) const {
+    assert(index < size_);
+    return ConstRow(this, index);
+  }
+
+  iterator begin() { return iterator(this, 0); }
+  iterator end() { return iterator(this, size_); }
+  const_iterator begin() const { return const_iterator(this, 0); }
+  const_iterator end() const { return const_iterator(this, size_); }
+
+  void Reserve(std::size_t capacity) {
+    if (capacity > capacity_) {
+      Reallocate(capacity);
+    }
+  }
+
+  // The arguments may refer into this vector: on growth they are read
+  // before the old block goes away.
+  template <class... Args>
+  requires (sizeof...(Args) == kColumns && (std::constructible_from<Ts, Args&&> && ...))
+  void PushBack(Args&&... args) {
+    ConstructAtEnd(1, [&](const ColumnPointers& target) {
+      std::size_t constructed = 0;
+      try {
+        [&]<std::size_t... Is>(std::index_sequence<Is...>) {
+          ((std::construct_at(ColumnAt<Is>(target) + size_, std::forward<Args>(args)), ++constructed), ...);
+        }(std::index_sequence_for<Ts...>{});
+      } catch (...) {
+        DestroyRow(target, size_, constructed);
+        throw;
+      }
+    });
+  }
+
+  // Bulk append: one sized range per column, all of the same length,
+  // copied column by column after a single capacity check. The ranges may
+  // view this vector's own columns.
+  template <class... Columns>
+  requires (sizeof...(Columns) == kColumns && (std::ranges::sized_range<Columns> && ...))
+  void Append(const Columns&... columns) {
+    const std::size_t count = std::ranges::size(std::get<0>(std::forward_as_tuple(columns...)));
+    assert(((static_cast<std::size_t>(std::ranges::size(columns)) == count) && ...));
+    ConstructAtEnd(count, [&](const ColumnPointers& target) {
+      std::size_t constructed = 0;
+      try {
+        [&]<std::size_t... Is>(std::index_sequence<Is...>) {
+          ((std::uninitialized_copy_n(std::ranges::begin(columns), count, ColumnAt<Is>(target) + size_),
+            ++constructed), ...);
+        }(std::index_sequence_for<Ts...>{});
+      } catch (...) {
+        ForEachColumn([&](auto column) {
+          constexpr std::size_t kI = decltype(column)::value;
+          if (kI < constructed) {
+            std::destroy_n(ColumnAt<kI>(target) + size_, count);
+          }
+        });
+        throw;
+      }
+    });
+  }
+
+  void PopBack() {
+    assert(size_ > 0);
+    --size_;
+    DestroyRow(columns_, size_, kColumns);
+  }
+
+  void Clear() noexcept {
+    ForEachColumn([&](auto column) {
+      std::destroy_n(ColumnData<decltype(column)::value>(), size_);
+    });
+    size_ = 0;
+  }
+
+private:
+  static constexpr std::size_t RoundUp(std::size_t bytes) noexcept {
+    return (bytes + alignment - 1) / alignment * alignment;
+  }
+
+  // Byte offsets of the columns for a given capacity, plus the total size.
+  static std::array<std::size_t, kColumns + 1> Offsets(std::size_t capacity) noexcept {
+    std::array<std::size_t, kColumns + 1> offsets{};
+    constexpr std::array<std::size_t, kColumns> kSizes{sizeof(Ts)...};
+    for (std::size_t i = 0; i < kColumns; ++i) {
+      offsets[i + 1] = offsets[i] + RoundUp(capacity * kSizes[i]);
+    }
+    return offsets;
+  }
+
+  static void Deallocate(std::byte* block) noexcept {
+    ::operator delete(block, std::align_val_t{alignment});
+  }
+
+  using ColumnPointers = std::array<std::byte*, kColumns>;
+
+  template <std::size_t I>
+  static Field<I>* ColumnAt(const ColumnPointers& columns) noexcept {
+    return std::assume_aligned<alignment>(reinterpret_cast<Field<I>*>(columns[I]));
+  }
+
+  template <std::size_t I>
+  Field<I>* ColumnData() noexcept {
+    return ColumnAt<I>(columns_);
+  }
+
+  template <std::size_t I>
+  const Field<I>* ColumnData() const noexcept {
+    return std::assume_aligned<alignment>(reinterpret_cast<const Field<I>*>(columns_[I]));
+  }
+
+  // Destroys the first `columns` fields of row `index`.
+  static void DestroyRow(const ColumnPointers& target, std::size_t index, std::size_t columns) noexcept {
+    ForEachColumn([&](auto column) {
+      constexpr std::size_t kI = decltype(column)::value;
+      if (kI < columns) {
+        std::destroy_at(ColumnAt<kI>(target) + index);
+      }
+    });
+  }
+
+  struct Block {
+    std::byte* data;
+    ColumnPointers columns;
+  };
+
+  static Block Allocate(std::size_t capacity) {
+    const auto offsets = Offsets(capacity);
+    Block block{static_cast<std::byte*>(::operator new(offsets[kColumns], std::align_val_t{alignment})), {}};
+    for (std::size_t i = 0; i < kColumns; ++i) {
+      block.columns[i] = block.data + offsets[i];
+    }
+    return block;
+  }
+
+  // Moves the rows into `block` and frees the old one.
+  void Adopt(const Block& block, std::size_t capacity) noexcept {
+    ForEachColumn([&](auto column) {
+      constexpr std::size_t kI = decltype(column)::value;
+      std::uninitialized_move_n(ColumnData<kI>(), size_, ColumnAt<kI>(block.columns));
+      std::destroy_n(ColumnData<kI>(), size_);
+    });
+    Deallocate(block_);
+    block_ = block.data;
+    columns_ = block.columns;
+    capacity_ = capacity;
+  }
+
+  void Reallocate(std::size_t capacity) {
+    Adopt(Allocate(capacity), capacity);
+  }
+
+  // Runs construct(columns) to build rows [size_, size_ + count) in the
+  // given columns and then counts them in. When the rows do not fit, they
+  // are built in a new block while the old rows are still in place, so
+  // construct may read from them; the old rows move over afterwards.
+  template <class Construct>
+  void ConstructAtEnd(std::size_t count, Construct&& construct) {
+    if (size_ + count <= capacity_) {
+      construct(columns_);
+    } else {
+      const std::size_t capacity = std::max(size_ + count, 2 * capacity_);
+      const Block block = Allocate(capacity);
+      try {
+        construct(block.columns);
+      } catch (...) {
+        Deallocate(block.data);
+        throw;
+      }
+      Adopt(block, capacity);
+    }
+    size_ += count;
+  }
+
+  std::byte* block_ = nullptr;
+  ColumnPointers columns_{};
+  std::size_t size_ = 0;
+  std::size_t capacity_ = 0;
+};
@@ -1,4 +1,8 @@
+#pragma once
+
 #include <algorithm>
+#include <array>
+#include <ranges>
 #include <span>
 #include <concepts>
 #include <cstdlib>
@@ -23,6 +27,104 @@ namespace detail {
 
 }
 
+template <class T, std::size_t extent>
+class Span;
+
+namespace detail {
+
+  // Consecutive sub-spans of `chunk` elements. A static chunk size yields
+  // Span<T, chunk> and stops before an incomplete tail, which Remainder()
+  // returns; a dynamic one yields Span<T> with a shorter last chunk.
+  template <class T, std::size_t chunk>
+  class ChunksView : private SpanSize<chunk> {
+  public:
+    using value_type = Span<T, chunk>;
+
+    class iterator {
+    public:
+      using iterator_category = std::random_access_iterator_tag;
+      using value_type = Span<T, chunk>;
+      using difference_type = std::ptrdiff_t;
+
+      iterator() = default;
+      iterator(T* data, std::size_t length, std::size_t chunk_size, std::size_t index)
+        : data_(data), length_(length), chunk_size_(chunk_size), index_(index) {}
+
+      value_type operator*() const { return At(data_, length_, chunk_size_, index_); }
+      value_type operator[](difference_type n) const { return At(data_, length_, chunk_size_, index_ + n); }
+
+      iterator& operator++() { ++index_; return *this; }
+      iterator operator++(int) { auto copy = *this; ++index_; return copy; }
+      iterator& operator--() { --index_; return *this; }
+      iterator operator--(int) { auto copy = *this; --index_; return copy; }
+      iterator& operator+=(difference_type n) { index_ += n; return *this; }
+      iterator& operator-=(difference_type n) { index_ -= n; return *this; }
+      friend iterator operator+(iterator it, difference_type n) { return it += n; }
+      friend iterator operator+(difference_type n, iterator it) { return it += n; }
+      friend iterator operator-(iterator it, difference_type n) { return it -= n; }
+      friend difference_type operator-(const iterator& lhs, const iterator& rhs) {
+        return static_cast<difference_type>(lhs.index_) - static_cast<difference_type>(rhs.index_);
+      }
+      friend bool operator==(const iterator& lhs, const iterator& rhs) { return lhs.index_ == rhs.index_; }
+      friend auto operator<=>(const iterator& lhs, const iterator& rhs) { return lhs.index_ <=> rhs.index_; }
+
+    private:
+      T* data_ = nullptr;
+      std::size_t length_ = 0;
+      std::size_t chunk_size_ = 0;
+      std::size_t index_ = 0;
+    };
+
+    ChunksView(T* data, std::size_t length, std::size_t chunk_size)
+      : SpanSize<chunk>(chunk_size), data_(data), length_(length) {
+      assert(ChunkSize() > 0);
+    }
+
+    std::size_t ChunkSize() const noexcept {
+      if constexpr (chunk == std::dynamic_extent) {
+        return this->size_;
+      } else {
+        return chunk;
+      }
+    }
+
+    std::size_t Size() const noexcept {
+      if constexpr (chunk == std::dynamic_extent) {
+        return (length_ + ChunkSize() - 1) / ChunkSize();
+      } else {
+        return length_ / chunk;
+      }
+    }
+
+    value_type operator[](std::size_t index) const {
+      assert(index < Size());
+      return At(data_, length_, ChunkSize(), index);
+    }
+
+    Span<T, std::dynamic_extent> Remainder() const {
+      const std::size_t covered = std::min(length_, Size() * ChunkSize());
+      return Span<T, std::dynamic_extent>(data_ + covered, length_ - covered);
+    }
+
+    iterator begin() const { return iterator(data_, length_, ChunkSize(), 0); }
+    iterator end() const { return iterator(data_, length_, ChunkSize(), Size()); }
+
+  private:
+    static value_type At(T* data, std::size_t length, std::size_t chunk_size, std::size_t index) {
+      T* first = data + index * chunk_size;
+      if constexpr (chunk == std::dynamic_extent) {
+        return value_type(first, std::min(chunk_size, length - index * chunk_size));
+      } else {
+        return value_type(first, chunk);
+      }
+    }
+
+    T* data_;
+    std::size_t length_;
+  };
+
+}
+
 template <class T, std::size_t extent = std::dynamic_extent>
 class Span : private detail::SpanSize<extent> {
 public:
@@ -65,7 +167,7 @@ public:
 
   template <class R>
   explicit(extent != std::dynamic_extent)
-  constexpr Span(R&& range) : detail::SpanSize<extent>(std::ranges::size(range)), data_(std::data(range)) {
+  constexpr Span(R&& range) : detail::SpanSize<extent>(std::ranges::size(range)), data_(std::to_address(std::begin(range))) {
 
   }
 
@@ -138,6 +240,15 @@ public:
     return Span<T> (data_ + Size() - Count, Count);
   }
 
+  template <std::size_t Count>
+  constexpr auto Chunks() const {
+    return detail::ChunksView<T, Count>(data_, Size(), Count);
+  }
+
+  constexpr auto Chunks(size_t Count) const {
+    return detail::ChunksView<T, std::dynamic_extent>(data_, Size(), Count);
+  }
+
 private:
   pointer data_ = nullptr;
 };
@@ -0,0 +1,475 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+#include <AlignedSpan.hpp>
+#include <Span.hpp>
+
+// Sum / MinMax / Find / Count / Transform / Fill / Copy over Span.
+//
+// Every kernel is written once against a vector width in bytes and is
+// instantiated for SSE (16), AVX2 (32) and AVX-512 (64); the widest one the
+// CPU supports is picked at runtime. Elements that are not plain arithmetic
+// types, and non-x86 targets, take the scalar path.
+//
+// With a static extent the trip count is a constant: small spans are
+// unrolled completely, bigger ones get a vector loop whose tail is known at
+// compile time (and vanishes when extent is a multiple of the lane count).
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define SPAN_SIMD_X86 1
+#define SPAN_SIMD_TARGET(isa) __attribute__((target(isa)))
+#else
+#define SPAN_SIMD_X86 0
+#define SPAN_SIMD_TARGET(isa)
+#endif
+
+#if defined(__GNUC__)
+#define SPAN_ALWAYS_INLINE inline __attribute__((always_inline))
+#else
+#define SPAN_ALWAYS_INLINE inline
+#endif
+
+#if defined(__GNUC__)
+#pragma GCC diagnostic push
+// Vectors only cross always_inline boundaries, so the ABI note does not apply.
+#pragma GCC diagnostic ignored "-Wpsabi"
+#endif
+
+namespace detail {
+
+  enum class SimdLevel { kScalar, kSse, kAvx2, kAvx512 };
+
+  inline SimdLevel DetectSimdLevel() noexcept {
+#if SPAN_SIMD_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw")) {
+      return SimdLevel::kAvx512;
+    }
+    if (__builtin_cpu_supports("avx2")) {
+      return SimdLevel::kAvx2;
+    }
+    return SimdLevel::kSse;
+#else
+    return SimdLevel::kScalar;
+#endif
+  }
+
+  inline SimdLevel ActiveSimdLevel() noexcept {
+    static const SimdLevel level = DetectSimdLevel();
+    return level;
+  }
+
+  // Types the vector extensions can hold directly.
+  template <class T>
+  concept SimdElement = std::is_arithmetic_v<T> && !std::same_as<T, bool> &&
+    (sizeof(T) == 1 || sizeof(T) == 2 || sizeof(T) == 4 || sizeof(T) == 8);
+
+  template <class T, std::size_t bytes>
+  struct VectorOf {
+    typedef T Type __attribute__((vector_size(bytes)));
+  };
+
+  template <class T>
+  using SignedOfSize =
+    std::conditional_t<sizeof(T) == 1, std::int8_t,
+    std::conditional_t<sizeof(T) == 2, std::int16_t,
+    std::conditional_t<sizeof(T) == 4, std::int32_t, std::int64_t>>>;
+
+  template <class V, class T>
+  SPAN_ALWAYS_INLINE V Load(const T* from) noexcept {
+    V result;
+    std::memcpy(&result, from, sizeof(V));
+    return result;
+  }
+
+  template <class V, class T>
+  SPAN_ALWAYS_INLINE void Store(T* to, const V& value) noexcept {
+    std::memcpy(to, &value, sizeof(V));
+  }
+
+  template <class V, class T>
+  SPAN_ALWAYS_INLINE V Splat(T value) noexcept {
+    V result;
+    for (std::size_t i = 0; i < sizeof(V) / sizeof(T); ++i) {
+      result[i] = value;
+    }
+    return result;
+  }
+
+  template <std::size_t extent>
+  constexpr std::size_t StaticOr(std::size_t size) noexcept {
+    if constexpr (extent == std::dynamic_extent) {
+      return size;
+    } else {
+      return extent;
+    }
+  }
+
+  // Last index covered by whole vectors of `lanes` elements.
+  template <std::size_t lanes, std::size_t extent>
+  constexpr std::size_t BlockedEnd(std::size_t size) noexcept {
+    const std::size_t n = StaticOr<extent>(size);
+    return n - n % lanes;
+  }
+
+  // Spans whose whole payload fits in two cache lines are unrolled outright.
+  template <class T, std::size_t extent>
+  constexpr bool kFullyUnrolled =
+    extent != std::dynamic_extent && extent * sizeof(T) <= 128;
+
+  template <class T, std::size_t extent, std::size_t alignment = alignof(T)>
+  struct SumKernel {
+    template <std::size_t bytes>
+    SPAN_ALWAYS_INLINE static T Run(const T* data, std::size_t size) {
+      data = std::assume_aligned<alignment>(data);
+      if constexpr (kFullyUnrolled<T, extent>) {
+        return [&]<std::size_t... I>(std::index_sequence<I...>) {
+          return static_cast<T>((T{} + ... + data[I]));
+        }(std::make_index_sequence<extent>{});
+      } else if constexpr (bytes == 0 || !SimdElement<T>) {
+        T result{};
+        for (std::size_t i = 0; i < StaticOr<extent>(size); ++i) {
+          result += data[i];
+        }
+        return result;
+      } else {
+        using V = typename VectorOf<T, bytes>::Type;
+        constexpr std::size_t lanes = bytes / sizeof(T);
+        const std::size_t blocked = BlockedEnd<lanes, extent>(size);
+        V acc{};
+        for (std::size_t i = 0; i < blocked; i += lanes) {
+          acc += Load<V>(data + i);
+        }
+        T result{};
+        for (std::size_t lane = 0; lane < lanes; ++lane) {
+          result += acc[lane];
+        }
+        for (std::size_t i = blocked; i < StaticOr<extent>(size); ++i) {
+          result += data[i];
+        }
+        return result;
+      }
+    }
+  };
+
+  template <class T, std::size_t extent, std::size_t alignment = alignof(T)>
+  struct MinMaxKernel {
+    template <std::size_t bytes>
+    SPAN_ALWAYS_INLINE static std::pair<T, T> Run(const T* data, std::size_t size) {
+      data = std::assume_aligned<alignment>(data);
+      const std::size_t n = StaticOr<extent>(size);
+      T lo = data[0];
+      T hi = data[0];
+      std::size_t i = 0;
+      if constexpr (!kFullyUnrolled<T, extent> && bytes != 0 && SimdElement<T>) {
+        using V = typename VectorOf<T, bytes>::Type;
+        constexpr std::size_t lanes = bytes / sizeof(T);
+        const std::size_t blocked = BlockedEnd<lanes, extent>(size);
+        if (blocked != 0) {
+          V vlo = Load<V>(data);
+          V vhi = vlo;
+          for (i = lanes; i < blocked; i += lanes) {
+            const V x = Load<V>(data + i);
+            vlo = x < vlo ? x : vlo;
+            vhi = vhi < x ? x : vhi;
+          }
+          for (std::size_t lane = 0; lane < lanes; ++lane) {
+            lo = vlo[lane] < lo ? vlo[lane] : lo;
+            hi = hi < vhi[lane] ? vhi[lane] : hi;
+          }
+        }
+      }
+      for (; i < n; ++i) {
+        lo = data[i] < lo ? data[i] : lo;
+        hi = hi < data[i] ? data[i] : hi;
+      }
+      return {lo, hi};
+    }
+  };
+
+  template <class T, std::size_t extent, std::size_t alignment = alignof(T)>
+  struct FindKernel {
+    template <std::size_t bytes>
+    SPAN_ALWAYS_INLINE static std::size_t Run(const T* data, std::size_t size, T value) {
+      data = std::assume_aligned<alignment>(data);
+      const std::size_t n = StaticOr<extent>(size);
+      std::size_t i = 0;
+      if constexpr (!kFullyUnrolled<T, extent> && bytes != 0 && SimdElement<T>) {
+        using V = typename VectorOf<T, bytes>::Type;
+        using Bits = typename VectorOf<std::int64_t, bytes>::Type;
+        constexpr std::size_t lanes = bytes / sizeof(T);
+        const std::size_t blocked = BlockedEnd<lanes, extent>(size);
+        const V needle = Splat<V>(value);
+        for (; i < blocked; i += lanes) {
+          const Bits hits = reinterpret_cast<Bits>(Load<V>(data + i) == needle);
+          std::int64_t any = 0;
+          for (std::size_t word = 0; word < bytes / sizeof(std::int64_t); ++word) {
+            any |= hits[word];
+          }
+          if (any != 0) {
+            break;
+          }
+        }
+      }
+      for (; i < n; ++i) {
+        if (data[i] == value) {
+          return i;
+        }
+      }
+      return n;
+    }
+  };
+
+  template <class T, std::size_t extent, std::size_t alignment = alignof(T)>
+  struct CountKernel {
+    template <std::size_t bytes>
+    SPAN_ALWAYS_INLINE static std::size_t Run(const T* data, std::size_t size, T value) {
+      data = std::assume_aligned<alignment>(data);
+      const std::size_t n = StaticOr<extent>(size);
+      std::size_t result = 0;
+      std::size_t i = 0;
+      if constexpr (!kFullyUnrolled<T, extent> && bytes != 0 && SimdElement<T>) {
+        using V = typename VectorOf<T, bytes>::Type;
+        using Mask = SignedOfSize<T>;
+        using M = typename VectorOf<Mask, bytes>::Type;
+        constexpr std::size_t lanes = bytes / sizeof(T);
+        // A true comparison is -1 in every lane; narrow lanes are drained
+        // into `result` before they can wrap. 64-bit lanes cannot wrap on
+        // any real size, so their chunk is only kept from overflowing.
+        constexpr std::size_t flush_every = std::min<std::size_t>(
+          static_cast<std::size_t>(std::numeric_limits<Mask>::max()) + 1,
+          std::numeric_limits<std::size_t>::max() / lanes);
+        constexpr std::size_t flush_chunk = flush_every * lanes;
+        const std::size_t blocked = BlockedEnd<lanes, extent>(size);
+        const V needle = Splat<V>(value);
+        while (i < blocked) {
+          const std::size_t stop = blocked - i > flush_chunk ? i + flush_chunk : blocked;
+          M acc{};
+          for (; i < stop; i += lanes) {
+            acc += reinterpret_cast<M>(Load<V>(data + i) == needle);
+          }
+          for (std::size_t lane = 0; lane < lanes; ++lane) {
+            result += static_cast<std::size_t>(-static_cast<std::int64_t>(acc[lane]));
+          }
+        }
+      }
+      for (; i < n; ++i) {
+        result += data[i] == value;
+      }
+      return result;
+    }
+  };
+
+  template <class T, std::size_t extent, std::size_t alignment = alignof(T)>
+  struct FillKernel {
+    template <std::size_t bytes>
+    SPAN_ALWAYS_INLINE static void Run(T* data, std::size_t size, T value) {
+      data = std::assume_aligned<alignment>(data);
+      std::size_t i = 0;
+      if constexpr (bytes != 0 && SimdElement<T>) {
+        using V = typename VectorOf<T, bytes>::Type;
+        constexpr std::size_t lanes = bytes / sizeof(T);
+        const std::size_t blocked = BlockedEnd<lanes, extent>(size);
+        const V splat = Splat<V>(value);
+        for (; i < blocked; i += lanes) {
+          Store(data + i, splat);
+        }
+      }
+      for (; i < StaticOr<extent>(size); ++i) {
+        data[i] = value;
+      }
+    }
+  };
+
+  // The callable is opaque, so Transform relies on the compiler vectorising
+  // the loop body; the dispatch only decides which instruction set it may use.
+  template <class T, class U, std::size_t extent, class F>
+  struct TransformKernel {
+    template <std::size_t bytes>
+    SPAN_ALWAYS_INLINE static void Run(const T* in, U* out, std::size_t size, F& fn) {
+      if constexpr (kFullyUnrolled<T, extent>) {
+        [&]<std::size_t... I>(std::index_sequence<I...>) {
+          ((out[I] = fn(in[I])), ...);
+        }(std::make_index_sequence<extent>{});
+      } else {
+        for (std::size_t i = 0; i < StaticOr<extent>(size); ++i) {
+          out[i] = fn(in[i]);
+        }
+      }
+    }
+  };
+
+  template <class Kernel, class... Args>
+  SPAN_SIMD_TARGET("avx512f,avx512bw")
+  decltype(auto) RunAvx512(Args&&... args) {
+    return Kernel::template Run<64>(std::forward<Args>(args)...);
+  }
+
+  template <class Kernel, class... Args>
+  SPAN_SIMD_TARGET("avx2")
+  decltype(auto) RunAvx2(Args&&... args) {
+    return Kernel::template Run<32>(std::forward<Args>(args)...);
+  }
+
+  template <class Kernel, class... Args>
+  decltype(auto) RunSse(Args&&... args) {
+    return Kernel::template Run<16>(std::forward<Args>(args)...);
+  }
+
+  template <class Kernel, class... Args>
+  decltype(auto) RunScalar(Args&&... args) {
+    return Kernel::template Run<0>(std::forward<Args>(args)...);
+  }
+
+  template <class Kernel, class... Args>
+  decltype(auto) Dispatch(Args&&... args) {
+#if SPAN_SIMD_X86
+    switch (ActiveSimdLevel()) {
+      case SimdLevel::kAvx512:
+        return RunAvx512<Kernel>(std::forward<Args>(args)...);
+      case SimdLevel::kAvx2:
+        return RunAvx2<Kernel>(std::forward<Args>(args)...);
+      case SimdLevel::kSse:
+        return RunSse<Kernel>(std::forward<Args>(args)...);
+      default:
+        break;
+    }
+#endif
+    return RunScalar<Kernel>(std::forward<Args>(args)...);
+  }
+
+}
+
+#if defined(__GNUC__)
+#pragma GCC diagnostic pop
+#endif
+
+namespace detail {
+
+  // The bodies of the algorithms below. A pointer's alignment does not
+  // survive the call into a target-specific kernel, so it travels as a
+  // template argument and each kernel restates it with assume_aligned.
+
+  template <std::size_t alignment, class T, std::size_t extent>
+  std::remove_cv_t<T> SumOf(Span<T, extent> span) {
+    using V = std::remove_cv_t<T>;
+    return Dispatch<SumKernel<V, extent, alignment>>(static_cast<const V*>(span.Data()), span.Size());
+  }
+
+  template <std::size_t alignment, class T, std::size_t extent>
+  std::pair<std::remove_cv_t<T>, std::remove_cv_t<T>> MinMaxOf(Span<T, extent> span) {
+    using V = std::remove_cv_t<T>;
+    assert(span.Size() > 0);
+    return Dispatch<MinMaxKernel<V, extent, alignment>>(static_cast<const V*>(span.Data()), span.Size());
+  }
+
+  template <std::size_t alignment, class T, std::size_t extent>
+  std::size_t FindIn(Span<T, extent> span, const std::remove_cv_t<T>& value) {
+    using V = std::remove_cv_t<T>;
+    return Dispatch<FindKernel<V, extent, alignment>>(static_cast<const V*>(span.Data()), span.Size(), value);
+  }
+
+  template <std::size_t alignment, class T, std::size_t extent>
+  std::size_t CountIn(Span<T, extent> span, const std::remove_cv_t<T>& value) {
+    using V = std::remove_cv_t<T>;
+    return Dispatch<CountKernel<V, extent, alignment>>(static_cast<const V*>(span.Data()), span.Size(), value);
+  }
+
+  template <std::size_t alignment, class T, std::size_t extent>
+  void FillIn(Span<T, extent> span, const T& value) {
+    Dispatch<FillKernel<T, extent, alignment>>(span.Data(), span.Size(), value);
+  }
+
+}
+
+// Each algorithm also takes an AlignedSpan as such, so that its kernel
+// knows the alignment (a Span parameter would slice it away).
+
+template <class T, std::size_t extent>
+std::remove_cv_t<T> Sum(Span<T, extent> span) {
+  return detail::SumOf<alignof(T)>(span);
+}
+
+template <class T, std::size_t extent, std::size_t alignment>
+std::remove_cv_t<T> Sum(AlignedSpan<T, extent, alignment> span) {
+  return detail::SumOf<alignment>(span);
+}
+
+// Smallest and largest element; the span must not be empty.
+template <class T, std::size_t extent>
+std::pair<std::remove_cv_t<T>, std::remove_cv_t<T>> MinMax(Span<T, extent> span) {
+  return detail::MinMaxOf<alignof(T)>(span);
+}
+
+template <class T, std::size_t extent, std::size_t alignment>
+std::pair<std::remove_cv_t<T>, std::remove_cv_t<T>> MinMax(AlignedSpan<T, extent, alignment> span) {
+  return detail::MinMaxOf<alignment>(span);
+}
+
+// Iterator to the first element equal to value, or end().
+template <class T, std::size_t extent>
+typename Span<T, extent>::iterator Find(Span<T, extent> span, const std::remove_cv_t<T>& value) {
+  return span.begin() + detail::FindIn<alignof(T)>(span, value);
+}
+
+template <class T, std::size_t extent, std::size_t alignment>
+typename Span<T, extent>::iterator Find(AlignedSpan<T, extent, alignment> span, const std::remove_cv_t<T>& value) {
+  return span.begin() + detail::FindIn<alignment>(span, value);
+}
+
+template <class T, std::size_t extent>
+std::size_t Count(Span<T, extent> span, const std::remove_cv_t<T>& value) {
+  return detail::CountIn<alignof(T)>(span, value);
+}
+
+template <class T, std::size_t extent, std::size_t alignment>
+std::size_t Count(AlignedSpan<T, extent, alignment> span, const std::remove_cv_t<T>& value) {
+  return detail::CountIn<alignment>(span, value);
+}
+
+template <class T, std::size_t extent>
+requires (!std::is_const_v<T>)
+void Fill(Span<T, extent> span, const T& value) {
+  detail::FillIn<alignof(T)>(span, value);
+}
+
+template <class T, std::size_t extent, std::size_t alignment>
+requires (!std::is_const_v<T>)
+void Fill(AlignedSpan<T, extent, alignment> span, const T& value) {
+  detail::FillIn<alignment>(span, value);
+}
+
+// out[i] = fn(in[i]) for every element of in; returns the end of the written range.
+template <class T, std::size_t extent, class U, std::size_t out_extent, class F>
+requires (!std::is_const_v<U>) && std::invocable<F&, const T&>
+U* Transform(Span<T, extent> in, Span<U, out_extent> out, F fn) {
+  using V = std::remove_cv_t<T>;
+  assert(in.Size() <= out.Size());
+  detail::Dispatch<detail::TransformKernel<V, U, extent, F>>(
+    static_cast<const V*>(in.Data()), out.Data(), in.Size(), fn);
+  return out.Data() + in.Size();
+}
+
+// Trivially copyable elements go through memmove, which with a static extent
+// is a constant-size copy the compiler expands inline.
+template <class T, std::size_t extent, class U, std::size_t out_extent>
+requires (!std::is_const_v<U>) && std::assignable_from<U&, const T&>
+U* Copy(Span<T, extent> in, Span<U, out_extent> out) {
+  assert(in.Size() <= out.Size());
+  if constexpr (std::is_same_v<std::remove_cv_t<T>, U> && std::is_trivially_copyable_v<U>) {
+    std::memmove(out.Data(), in.Data(), detail::StaticOr<extent>(in.Size()) * sizeof(U));
+  } else {
+    std::copy(in.begin(), in.end(), out.begin());
+  }
+  return out.Data() + in.Size();
+}
@@ -0,0 +1,520 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <concepts>
+#include <cstddef>
+#include <functional>
+#include <span>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include <Span.hpp>
+
+// Run-time counterparts of the type_lists combinators over Span.
+//
+// A pipeline is a chain of stages that push their elements into a sink:
+// ForEach(sink) calls sink(element) until the sink returns false or the
+// stream ends, and every stage wraps the sink of the next one. After
+// inlining the whole chain is one loop in the source, with no buffers in
+// between.
+//
+// Stages that only remap positions (spans, Map, Take, Drop, Zip) are also
+// indexed: they expose Size() and At(i), and Take/Drop/Zip over them stay
+// index arithmetic rather than counters. Their kExtent is static whenever
+// the source is a fixed-extent Span, so the trip count is a constant and
+// ToArray() can return a std::array.
+//
+//   auto squares = Span(data) | pipeline::Map(square) | pipeline::Take<8>();
+//   auto total = pipeline::Foldl(squares, std::plus{}, 0);
+
+namespace pipeline {
+
+  struct StreamBase {};
+
+  template <class S>
+  concept Stream = std::derived_from<S, StreamBase>;
+
+  template <class S>
+  concept IndexedStream = Stream<S> && S::kIndexed;
+
+  namespace detail {
+
+    template <class S, class Sink>
+    bool ForEachIndexed(const S& stream, Sink& sink) {
+      const std::size_t size = stream.Size();
+      for (std::size_t i = 0; i < size; ++i) {
+        if (!sink(stream.At(i))) {
+          return false;
+        }
+      }
+      return true;
+    }
+
+    constexpr std::size_t MinExtent(std::size_t lhs, std::size_t rhs) noexcept {
+      if (lhs == std::dynamic_extent || rhs == std::dynamic_extent) {
+        return std::dynamic_extent;
+      }
+      return std::min(lhs, rhs);
+    }
+
+    // The run-time count of a Take/Drop, or nothing when it is static.
+    template <std::size_t count>
+    struct Count {
+      explicit Count(std::size_t) {}
+      static constexpr std::size_t Value() noexcept { return count; }
+    };
+
+    template <>
+    struct Count<std::dynamic_extent> {
+      explicit Count(std::size_t count) : count_(count) {}
+      std::size_t Value() const noexcept { return count_; }
+      std::size_t count_;
+    };
+
+  }
+
+  // Sources.
+
+  template <class T, std::size_t extent = std::dynamic_extent>
+  class SpanSource : public StreamBase {
+  public:
+    static constexpr bool kIndexed = true;
+    static constexpr std::size_t kExtent = extent;
+
+    explicit SpanSource(Span<T, extent> span) : span_(span) {}
+
+    constexpr std::size_t Size() const noexcept { return span_.Size(); }
+    T& At(std::size_t index) const { return span_.Data()[index]; }
+
+    Span<T, extent> View() const noexcept { return span_; }
+
+    template <class Sink>
+    bool ForEach(Sink&& sink) const {
+      return detail::ForEachIndexed(*this, sink);
+    }
+
+  private:
+    Span<T, extent> span_;
+  };
+
+  template <class T, std::size_t extent>
+  SpanSource<T, extent> From(Span<T, extent> span) {
+    return SpanSource<T, extent>(span);
+  }
+
+  template <class R>
+  requires (!Stream<std::remove_cvref_t<R>>)
+  auto From(R&& range) {
+    return From(Span(std::forward<R>(range)));
+  }
+
+  // x, f(x), f(f(x)), ... without end.
+  template <class T, class F>
+  class IterateSource : public StreamBase {
+  public:
+    static constexpr bool kIndexed = false;
+    static constexpr std::size_t kExtent = std::dynamic_extent;
+
+    IterateSource(T init, F f) : init_(std::move(init)), f_(std::move(f)) {}
+
+    template <class Sink>
+    bool ForEach(Sink&& sink) const {
+      for (T value = init_; sink(std::as_const(value));) {
+        value = std::invoke(f_, std::as_const(value));
+      }
+      return false;
+    }
+
+  private:
+    T init_;
+    F f_;
+  };
+
+  template <class T, class F>
+  IterateSource<T, F> Iterate(T init, F f) {
+    return IterateSource<T, F>(std::move(init), std::move(f));
+  }
+
+  // The elements of a finite indexed stream over and over; endless unless it is empty.
+  template <IndexedStream S>
+  class CycleStage : public StreamBase {
+  public:
+    static constexpr bool kIndexed = false;
+    static constexpr std::size_t kExtent = std::dynamic_extent;
+
+    explicit CycleStage(S stream) : stream_(std::move(stream)) {}
+
+    template <class Sink>
+    bool ForEach(Sink&& sink) const {
+      if (stream_.Size() == 0) {
+        return true;
+      }
+      while (detail::ForEachIndexed(stream_, sink)) {
+      }
+      return false;
+    }
+
+  private:
+    S stream_;
+  };
+
+  template <IndexedStream S>
+  CycleStage<S> Cycle(S stream) {
+    return CycleStage<S>(std::move(stream));
+  }
+
+  template <class R>
+  requires (!Stream<std::remove_cvref_t<R>>)
+  auto Cycle(R&& range) {
+    return Cycle(From(std::forward<R>(range)));
+  }
+
+  // Tuples of the i-th elements of indexed streams, as long as the shortest one.
+  template <IndexedStream... Ss>
+  class ZipStage : public StreamBase {
+  public:
+    static constexpr bool kIndexed = true;
+    static constexpr std::size_t kExtent = [] {
+      std::size_t extent = std::dynamic_extent;
+      bool first = true;
+      ((extent = first ? Ss::kExtent : detail::MinExtent(extent, Ss::kExtent), first = false), ...);
+      return extent;
+    }();
+
+    explicit ZipStage(Ss... streams) : streams_(std::move(streams)...) {}
+
+    constexpr std::size_t Size() const {
+      return std::apply([](const auto&... streams) { return std::min({streams.Size()...}); }, streams_);
+    }
+
+    auto At(std::size_t index) const {
+      return std::apply([index](const auto&... streams) {
+        return std::tuple<decltype(streams.At(index))...>(streams.At(index)...);
+      }, streams_);
+    }
+
+    template <class Sink>
+    bool ForEach(Sink&& sink) const {
+      return detail::ForEachIndexed(*this, sink);
+    }
+
+  private:
+    std::tuple<Ss...> streams_;
+  };
+
+  template <class... Rs>
+  requires (sizeof...(Rs) > 0)
+  auto Zip(Rs&&... streams) {
+    auto as_stream = []<class R>(R&& r) {
+      if constexpr (Stream<std::remove_cvref_t<R>>) {
+        return std::forward<R>(r);
+      } else {
+        return From(std::forward<R>(r));
+      }
+    };
+    return ZipStage<decltype(as_stream(std::forward<Rs>(streams)))...>(as_stream(std::forward<Rs>(streams))...);
+  }
+
+  // Stages.
+
+  template <Stream S, class F>
+  class MapStage : public StreamBase {
+  public:
+    static constexpr bool kIndexed = IndexedStream<S>;
+    static constexpr std::size_t kExtent = S::kExtent;
+
+    MapStage(S stream, F f) : stream_(std::move(stream)), f_(std::move(f)) {}
+
+    constexpr std::size_t Size() const requires kIndexed { return stream_.Size(); }
+    decltype(auto) At(std::size_t index) const requires kIndexed { return std::invoke(f_, stream_.At(index)); }
+
+    template <class Sink>
+    bool ForEach(Sink&& sink) const {
+      return stream_.ForEach([&](auto&& value) -> bool {
+        return sink(std::invoke(f_, std::forward<decltype(value)>(value)));
+      });
+    }
+
+  private:
+    S stream_;
+    F f_;
+  };
+
+  template <Stream S, class P>
+  class FilterStage : public StreamBase {
+  public:
+    static constexpr bool kIndexed = false;
+    static constexpr std::size_t kExtent = std::dynamic_extent;
+
+    FilterStage(S stream, P p) : stream_(std::move(stream)), p_(std::move(p)) {}
+
+    template <class Sink>
+    bool ForEach(Sink&& sink) const {
+      return stream_.ForEach([&](auto&& value) -> bool {
+        return !std::invoke(p_, std::as_const(value)) || sink(std::forward<decltype(value)>(value));
+      });
+    }
+
+  private:
+    S stream_;
+    P p_;
+  };
+
+  template <Stream S, std::size_t count>
+  class TakeStage : public StreamBase, private detail::Count<count> {
+    using Count = detail::Count<count>;
+
+  public:
+    static constexpr bool kIndexed = IndexedStream<S>;
+    static constexpr std::size_t kExtent = IndexedStream<S> ? detail::MinExtent(count, S::kExtent) : std::dynamic_extent;
+
+    TakeStage(S stream, std::size_t n) : Count(n), stream_(std::move(stream)) {}
+
+    constexpr std::size_t Size() const requires kIndexed {
+      if constexpr (kExtent != std::dynamic_extent) {
+        return kExtent;
+      } else {
+        return std::min(Count::Value(), stream_.Size());
+      }
+    }
+
+    decltype(auto) At(std::size_t index) const requires kIndexed { return stream_.At(index); }
+
+    template <class Sink>
+    bool ForEach(Sink&& sink) const {
+      if constexpr (kIndexed) {
+        return detail::ForEachIndexed(*this, sink);
+      } else {
+        std::size_t remaining = Count::Value();
+        if (remaining == 0) {
+          return true;
+        }
+        bool accepted = true;
+        stream_.ForEach([&](auto&& value) -> bool {
+          accepted = sink(std::forward<decltype(value)>(value));
+          return accepted && --remaining > 0;
+        });
+        return accepted;
+      }
+    }
+
+  private:
+    S stream_;
+  };
+
+  template <Stream S, std::size_t count>
+  class DropStage : public StreamBase, private detail::Count<count> {
+    using Count = detail::Count<count>;
+
+  public:
+    static constexpr bool kIndexed = IndexedStream<S>;
+    static constexpr std::size_t kExtent = IndexedStream<S> && count != std::dynamic_extent && S::kExtent != std::dynamic_extent
+      ? S::kExtent - std::min(count, S::kExtent)
+      : std::dynamic_extent;
+
+    DropStage(S stream, std::size_t n) : Count(n), stream_(std::move(stream)) {}
+
+    constexpr std::size_t Size() const requires kIndexed {
+      if constexpr (kExtent != std::dynamic_extent) {
+        return kExtent;
+      } else {
+        return stream_.Size() - std::min(Count::Value(), stream_.Size());
+      }
+    }
+
+    decltype(auto) At(std::size_t index) const requires kIndexed { return stream_.At(index + Count::Value()); }
+
+    template <class Sink>
+    bool ForEach(Sink&& sink) const {
+      if constexpr (kIndexed) {
+        return detail::ForEachIndexed(*this, sink);
+      } else {
+        std::size_t skip = Count::Value();
+        return stream_.ForEach([&](auto&& value) -> bool {
+          if (skip > 0) {
+            --skip;
+            return true;
+          }
+          return sink(std::forward<decltype(value)>(value));
+        });
+      }
+    }
+
+  private:
+    S stream_;
+  };
+
+  // init first, then each next value is op(previous, element).
+  template <Stream S, class Op, class T>
+  class ScanlStage : public StreamBase {
+  public:
+    static constexpr bool kIndexed = false;
+    static constexpr std::size_t kExtent = S::kExtent == std::dynamic_extent ? std::dynamic_extent : S::kExtent + 1;
+
+    ScanlStage(S stream, Op op, T init) : stream_(std::move(stream)), op_(std::move(op)), init_(std::move(init)) {}
+
+    template <class Sink>
+    bool ForEach(Sink&& sink) const {
+      T accumulator = init_;
+      if (!sink(std::as_const(accumulator))) {
+        return false;
+      }
+      return stream_.ForEach([&](auto&& value) -> bool {
+        accumulator = std::invoke(op_, std::move(accumulator), std::forward<decltype(value)>(value));
+        return sink(std::as_const(accumulator));
+      });
+    }
+
+  private:
+    S stream_;
+    Op op_;
+    T init_;
+  };
+
+  // Runs of elements equal to the first one of the run, as sub-spans of the
+  // source; only available directly on a span, since groups are not copied.
+  template <class T, std::size_t extent, class Eq>
+  class GroupByStage : public StreamBase {
+  public:
+    static constexpr bool kIndexed = false;
+    static constexpr std::size_t kExtent = std::dynamic_extent;
+
+    GroupByStage(SpanSource<T, extent> source, Eq eq) : span_(source.View()), eq_(std::move(eq)) {}
+
+    template <class Sink>
+    bool ForEach(Sink&& sink) const {
+      T* data = span_.Data();
+      const std::size_t size = span_.Size();
+      for (std::size_t first = 0, last = 0; first < size; first = last) {
+        for (last = first + 1; last < size && std::invoke(eq_, std::as_const(data[first]), std::as_const(data[last])); ++last) {
+        }
+        if (!sink(Span<T>(data + first, last - first))) {
+          return false;
+        }
+      }
+      return true;
+    }
+
+  private:
+    Span<T, extent> span_;
+    Eq eq_;
+  };
+
+  // Adaptors: `stream | Map(f)` and the like.
+
+  template <class Make>
+  struct Adaptor {
+    Make make;
+  };
+
+  template <Stream S, class Make>
+  auto operator|(S stream, Adaptor<Make> adaptor) {
+    return adaptor.make(std::move(stream));
+  }
+
+  template <class T, std::size_t extent, class Make>
+  auto operator|(Span<T, extent> span, Adaptor<Make> adaptor) {
+    return From(span) | std::move(adaptor);
+  }
+
+  template <class F>
+  auto Map(F f) {
+    return Adaptor{[f = std::move(f)]<Stream S>(S stream) { return MapStage<S, F>(std::move(stream), f); }};
+  }
+
+  template <class P>
+  auto Filter(P p) {
+    return Adaptor{[p = std::move(p)]<Stream S>(S stream) { return FilterStage<S, P>(std::move(stream), p); }};
+  }
+
+  template <std::size_t count>
+  auto Take() {
+    return Adaptor{[]<Stream S>(S stream) { return TakeStage<S, count>(std::move(stream), count); }};
+  }
+
+  inline auto Take(std::size_t count) {
+    return Adaptor{[count]<Stream S>(S stream) { return TakeStage<S, std::dynamic_extent>(std::move(stream), count); }};
+  }
+
+  template <std::size_t count>
+  auto Drop() {
+    return Adaptor{[]<Stream S>(S stream) { return DropStage<S, count>(std::move(stream), count); }};
+  }
+
+  inline auto Drop(std::size_t count) {
+    return Adaptor{[count]<Stream S>(S stream) { return DropStage<S, std::dynamic_extent>(std::move(stream), count); }};
+  }
+
+  template <class Op, class T>
+  auto Scanl(Op op, T init) {
+    return Adaptor{[op = std::move(op), init = std::move(init)]<Stream S>(S stream) {
+      return ScanlStage<S, Op, T>(std::move(stream), op, init);
+    }};
+  }
+
+  template <class Eq = std::equal_to<>>
+  auto GroupBy(Eq eq = {}) {
+    return Adaptor{[eq = std::move(eq)]<class T, std::size_t extent>(SpanSource<T, extent> source) {
+      return GroupByStage<T, extent, Eq>(source, eq);
+    }};
+  }
+
+  // Terminals.
+
+  template <Stream S, class F>
+  void ForEach(const S& stream, F&& f) {
+    stream.ForEach([&](auto&& value) -> bool {
+      std::invoke(f, std::forward<decltype(value)>(value));
+      return true;
+    });
+  }
+
+  template <Stream S, class Op, class T>
+  T Foldl(const S& stream, Op&& op, T init) {
+    stream.ForEach([&](auto&& value) -> bool {
+      init = std::invoke(op, std::move(init), std::forward<decltype(value)>(value));
+      return true;
+    });
+    return init;
+  }
+
+  template <Stream S>
+  std::size_t Count(const S& stream) {
+    if constexpr (IndexedStream<S>) {
+      return stream.Size();
+    } else {
+      std::size_t count = 0;
+      stream.ForEach([&](auto&&) -> bool {
+        ++count;
+        return true;
+      });
+      return count;
+    }
+  }
+
+  // Writes elements until either side runs out; returns how many were written.
+  template <Stream S, class T, std::size_t extent>
+  std::size_t CopyTo(const S& stream, Span<T, extent> out) {
+    std::size_t written = 0;
+    if (out.Size() == 0) {
+      return 0;
+    }
+    stream.ForEach([&](auto&& value) -> bool {
+      out.Data()[written] = std::forward<decltype(value)>(value);
+      return ++written < out.Size();
+    });
+    return written;
+  }
+
+  template <IndexedStream S>
+  requires (S::kExtent != std::dynamic_extent)
+  auto ToArray(const S& stream) {
+    using Value = std::remove_cvref_t<decltype(stream.At(0))>;
+    return [&]<std::size_t... Is>(std::index_sequence<Is...>) {
+      return std::array<Value, S::kExtent>{stream.At(Is)...};
+    }(std::make_index_sequence<S::kExtent>{});
+  }
+
+}
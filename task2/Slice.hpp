@@ -1,65 +1,363 @@
+#pragma once
+
 #include <span>
 #include <concepts>
 #include <cstdlib>
 #include <array>
+#include <cassert>
+#include <compare>
 #include <iterator>
+#include <ranges>
+#include <type_traits>
 
 
 inline constexpr std::ptrdiff_t dynamic_stride = -1;
 
+namespace detail {
+
+  // Extent and stride are only stored when they are not known statically,
+  // so Slice<T, N, 1> is a lone pointer, just like Span<T, N>.
+
+  template <std::size_t extent>
+  struct SliceExtent {
+    constexpr SliceExtent(std::size_t size) noexcept {
+      assert(size == extent);
+    }
+    constexpr std::size_t GetExtent() const noexcept {
+      return extent;
+    }
+  };
+
+  template <>
+  struct SliceExtent<std::dynamic_extent> {
+    std::size_t extent_;
+    constexpr SliceExtent(std::size_t size) noexcept : extent_(size) {}
+    constexpr std::size_t GetExtent() const noexcept {
+      return extent_;
+    }
+  };
+
+  template <std::ptrdiff_t stride>
+  struct SliceStride {
+    constexpr SliceStride(std::ptrdiff_t skip) noexcept {
+      assert(skip == stride);
+    }
+    constexpr std::ptrdiff_t GetStride() const noexcept {
+      return stride;
+    }
+  };
+
+  template <>
+  struct SliceStride<dynamic_stride> {
+    std::ptrdiff_t stride_;
+    constexpr SliceStride(std::ptrdiff_t skip) noexcept : stride_(skip) {}
+    constexpr std::ptrdiff_t GetStride() const noexcept {
+      return stride_;
+    }
+  };
+
+  constexpr std::size_t SkippedExtent(std::size_t extent, std::ptrdiff_t skip) {
+    const std::size_t step = static_cast<std::size_t>(skip > 0 ? skip : -skip);
+    return extent == std::dynamic_extent ? std::dynamic_extent : (extent + step - 1) / step;
+  }
+
+  // A composed stride of -1 would read as dynamic_stride, which is also
+  // exactly how it gets stored.
+  constexpr std::ptrdiff_t SkippedStride(std::ptrdiff_t stride, std::ptrdiff_t skip) {
+    return stride == dynamic_stride ? dynamic_stride : stride * skip;
+  }
+
+}
+
 
 template
   < class T
   , std::size_t extent = std::dynamic_extent
   , std::ptrdiff_t stride = 1
   >
-class Slice {
+class Slice
+  : private detail::SliceExtent<extent>
+  , private detail::SliceStride<stride> {
 public:
+  using element_type = T;
+  using value_type = std::remove_cv_t<T>;
+  using reference = T&;
+  using pointer = T*;
+  using size_type = std::size_t;
+  using difference_type = std::ptrdiff_t;
+
+  // Walks the elements by index, so the end position is never formed as a
+  // pointer that may lie past the underlying array, and distance/advance are
+  // O(1) for every stride, negative ones included. With a static unit stride
+  // the iterator is contiguous, so std algorithms can fall back to memmove.
+  class iterator : private detail::SliceStride<stride> {
+  public:
+    using iterator_concept = std::conditional_t<stride == 1,
+      std::contiguous_iterator_tag, std::random_access_iterator_tag>;
+    using iterator_category = std::random_access_iterator_tag;
+    using value_type = std::remove_cv_t<T>;
+    using element_type = T;
+    using difference_type = std::ptrdiff_t;
+    using reference = T&;
+    using pointer = T*;
+
+    constexpr iterator() noexcept : detail::SliceStride<stride>(stride == dynamic_stride ? 1 : stride) {}
+    constexpr iterator(T* data, std::ptrdiff_t skip, std::ptrdiff_t index) noexcept
+      : detail::SliceStride<stride>(skip), data_(data), index_(index) {}
+
+    constexpr reference operator*() const noexcept {
+      return data_[index_ * this->GetStride()];
+    }
+
+    constexpr pointer operator->() const noexcept {
+      return data_ + index_ * this->GetStride();
+    }
+
+    constexpr reference operator[](difference_type n) const noexcept {
+      return data_[(index_ + n) * this->GetStride()];
+    }
+
+    constexpr iterator& operator++() noexcept {
+      ++index_;
+      return *this;
+    }
+
+    constexpr iterator operator++(int) noexcept {
+      auto copy = *this;
+      ++index_;
+      return copy;
+    }
+
+    constexpr iterator& operator--() noexcept {
+      --index_;
+      return *this;
+    }
+
+    constexpr iterator operator--(int) noexcept {
+      auto copy = *this;
+      --index_;
+      return copy;
+    }
+
+    constexpr iterator& operator+=(difference_type n) noexcept {
+      index_ += n;
+      return *this;
+    }
+
+    constexpr iterator& operator-=(difference_type n) noexcept {
+      index_ -= n;
+      return *this;
+    }
+
+    friend constexpr iterator operator+(iterator it, difference_type n) noexcept {
+      return it += n;
+    }
+
+    friend constexpr iterator operator+(difference_type n, iterator it) noexcept {
+      return it += n;
+    }
+
+    friend constexpr iterator operator-(iterator it, difference_type n) noexcept {
+      return it -= n;
+    }
+
+    friend constexpr difference_type operator-(const iterator& lhs, const iterator& rhs) noexcept {
+      return lhs.index_ - rhs.index_;
+    }
+
+    friend constexpr bool operator==(const iterator& lhs, const iterator& rhs) noexcept {
+      return lhs.index_ == rhs.index_;
+    }
+
+    friend constexpr std::strong_ordering operator<=>(const iterator& lhs, const iterator& rhs) noexcept {
+      return lhs.index_ <=> rhs.index_;
+    }
+
+  private:
+    T* data_ = nullptr;
+    std::ptrdiff_t index_ = 0;
+  };
+
+  using reverse_iterator = std::reverse_iterator<iterator>;
+
+  constexpr Slice() noexcept
+  requires (extent == 0 || extent == std::dynamic_extent)
+    : detail::SliceExtent<extent>(0)
+    , detail::SliceStride<stride>(stride == dynamic_stride ? 1 : stride)
+  {}
+
   template<class U>
-  Slice(U& container);
+  requires std::ranges::contiguous_range<U&> && std::ranges::sized_range<U&>
+    && (stride == 1 || stride == dynamic_stride)
+  constexpr Slice(U& container)
+    : detail::SliceExtent<extent>(std::ranges::size(container))
+    , detail::SliceStride<stride>(1)
+    , data_(std::ranges::data(container))
+  {}
 
   template <std::contiguous_iterator It>
-  Slice(It first, std::size_t count, std::ptrdiff_t skip);
+  constexpr Slice(It first, std::size_t count, std::ptrdiff_t skip)
+    : detail::SliceExtent<extent>(count)
+    , detail::SliceStride<stride>(skip)
+    , data_(std::to_address(first))
+  {}
+
+  // Forgetting a static extent or stride, or adding const, is implicit.
+  template <class U, std::size_t other_extent, std::ptrdiff_t other_stride>
+  requires std::is_convertible_v<U(*)[], T(*)[]>
+    && (extent == std::dynamic_extent || extent == other_extent)
+    && (stride == dynamic_stride || stride == other_stride)
+    && (!std::same_as<Slice<U, other_extent, other_stride>, Slice>)
+  constexpr Slice(const Slice<U, other_extent, other_stride>& other) noexcept
+    : Slice(other.Data(), other.Size(), other.Stride())
+  {}
+
+  constexpr Slice(const Slice&) noexcept = default;
+  constexpr Slice& operator=(const Slice&) noexcept = default;
+
+  constexpr pointer Data() const noexcept {
+    return data_;
+  }
+
+  constexpr size_type Size() const noexcept {
+    return this->GetExtent();
+  }
+
+  constexpr bool Empty() const noexcept {
+    return Size() == 0;
+  }
+
+  constexpr difference_type Stride() const noexcept {
+    return this->GetStride();
+  }
+
+  constexpr reference operator[](size_type index) const {
+    assert(index < Size());
+    return data_[static_cast<difference_type>(index) * Stride()];
+  }
 
-  // Data, Size, Stride, begin, end, casts, etc...
+  constexpr reference Front() const {
+    assert(!Empty());
+    return *data_;
+  }
+
+  constexpr reference Back() const {
+    assert(!Empty());
+    return (*this)[Size() - 1];
+  }
+
+  constexpr iterator begin() const noexcept {
+    return iterator(data_, Stride(), 0);
+  }
+
+  constexpr iterator end() const noexcept {
+    return iterator(data_, Stride(), static_cast<difference_type>(Size()));
+  }
+
+  constexpr reverse_iterator rbegin() const noexcept {
+    return reverse_iterator(end());
+  }
+
+  constexpr reverse_iterator rend() const noexcept {
+    return reverse_iterator(begin());
+  }
 
   Slice<T, std::dynamic_extent, stride>
-    First(std::size_t count) const;
+    First(std::size_t count) const {
+    assert(count <= Size());
+    return {data_, count, Stride()};
+  }
 
   template <std::size_t count>
-  Slice<T, /*?*/, stride>
-    First() const;
+  Slice<T, count, stride>
+    First() const {
+    assert(count <= Size());
+    return {data_, count, Stride()};
+  }
 
   Slice<T, std::dynamic_extent, stride>
-    Last(std::size_t count) const;
+    Last(std::size_t count) const {
+    assert(count <= Size());
+    return {At(Size() - count), count, Stride()};
+  }
 
   template <std::size_t count>
-  Slice<T, /*?*/, stride>
-    Last() const;
+  Slice<T, count, stride>
+    Last() const {
+    assert(count <= Size());
+    return {At(Size() - count), count, Stride()};
+  }
 
   Slice<T, std::dynamic_extent, stride>
-    DropFirst(std::size_t count) const;
+    DropFirst(std::size_t count) const {
+    assert(count <= Size());
+    return {At(count), Size() - count, Stride()};
+  }
 
   template <std::size_t count>
-  Slice<T, /*?*/, stride>
-    DropFirst() const;
+  Slice<T, (extent == std::dynamic_extent ? std::dynamic_extent : extent - count), stride>
+    DropFirst() const {
+    assert(count <= Size());
+    return {At(count), Size() - count, Stride()};
+  }
 
   Slice<T, std::dynamic_extent, stride>
-    DropLast(std::size_t count) const;
+    DropLast(std::size_t count) const {
+    assert(count <= Size());
+    return {data_, Size() - count, Stride()};
+  }
 
   template <std::size_t count>
-  Slice<T, /*?*/, stride>
-    DropLast() const;
+  Slice<T, (extent == std::dynamic_extent ? std::dynamic_extent : extent - count), stride>
+    DropLast() const {
+    assert(count <= Size());
+    return {data_, Size() - count, Stride()};
+  }
 
-  Slice<T, /*?*/, /*?*/>
-    Skip(std::ptrdiff_t skip) const;
+  Slice<T, std::dynamic_extent, dynamic_stride>
+    Skip(std::ptrdiff_t skip) const {
+    assert(skip != 0);
+    const std::size_t step = static_cast<std::size_t>(skip > 0 ? skip : -skip);
+    return {skip > 0 ? data_ : At(Size() - 1), (Size() + step - 1) / step, Stride() * skip};
+  }
 
+  // A negative skip walks backwards from the last element: Skip<-1>() is
+  // the reversed slice.
   template <std::ptrdiff_t skip>
-  Slice<T, /*?*/, /*?*/>
-    Skip() const;
+  requires (skip != 0)
+  Slice<T, detail::SkippedExtent(extent, skip), detail::SkippedStride(stride, skip)>
+    Skip() const {
+    constexpr std::size_t step = static_cast<std::size_t>(skip > 0 ? skip : -skip);
+    return {skip > 0 ? data_ : At(Size() - 1), (Size() + step - 1) / step, Stride() * skip};
+  }
+
+  auto Reversed() const {
+    return Skip<-1>();
+  }
 
 private:
-  T* data_;
-  // std::size_t extent_; ?
-  // std::ptrdiff_t stride_; ?
+  // Address of element `index`. Element Size() may lie beyond the buffer,
+  // so an empty remainder keeps the original pointer instead.
+  constexpr pointer At(std::size_t index) const noexcept {
+    return index >= Size() ? data_ : data_ + static_cast<difference_type>(index) * Stride();
+  }
+
+  T* data_ = nullptr;
 };
+
+template <class U>
+Slice(U&) -> Slice<std::remove_reference_t<std::ranges::range_reference_t<U&>>>;
+
+template <class T, std::size_t N>
+Slice(std::array<T, N>&) -> Slice<T, N>;
+
+template <class T, std::size_t N>
+Slice(const std::array<T, N>&) -> Slice<const T, N>;
+
+template <std::contiguous_iterator It>
+Slice(It, std::size_t, std::ptrdiff_t)
+  -> Slice<std::remove_reference_t<std::iter_reference_t<It>>, std::dynamic_extent, dynamic_stride>;
+
+static_assert(std::random_access_iterator<Slice<int, std::dynamic_extent, dynamic_stride>::iterator>);
+static_assert(std::contiguous_iterator<Slice<int>::iterator>);
+static_assert(std::ranges::random_access_range<Slice<const int, 4, 2>>);
@@ -0,0 +1,264 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <utility>
+
+#include <Slice.hpp>
+#include <Span.hpp>
+#include <SpanAlgorithms.hpp>
+
+#if SPAN_SIMD_X86
+#include <immintrin.h>
+#endif
+
+// Gather / Scatter / Transform between strided Slices and contiguous Spans,
+// e.g. pulling the x column out of an array of xyz triples.
+//
+// Gather picks, per instruction set (see SpanAlgorithms.hpp for dispatch):
+//   * stride 1: a plain copy;
+//   * small static strides (2..8): load `stride` full vectors and pick every
+//     stride-th lane with a chain of two-input shuffles;
+//   * anything else with 4- or 8-byte elements: AVX2 / AVX-512 hardware gather;
+//   * otherwise, and for tails, a scalar loop.
+// Scatter uses AVX-512 scatter for 4- and 8-byte elements and scalar stores
+// elsewhere, since AVX2 has no scatter instruction.
+
+#if defined(__GNUC__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wpsabi"
+// The gather intrinsics start from _mm*_undefined_*(), which GCC flags.
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#endif
+
+namespace detail {
+
+  inline constexpr std::ptrdiff_t kMaxShuffleStride = 8;
+
+  // Lane `lane` of the result comes from lane (lane * stride) % lanes of
+  // input vector (lane * stride) / lanes.
+  constexpr std::size_t DeinterleaveSource(std::size_t lane, std::size_t stride, std::size_t lanes) {
+    return lane * stride / lanes;
+  }
+
+  // Step `step` keeps what is already gathered (indices < lanes) and takes
+  // the lanes whose source is input vector `step` from the second operand.
+  constexpr std::size_t DeinterleaveMask(std::size_t step, std::size_t lane,
+                                         std::size_t stride, std::size_t lanes) {
+    if (DeinterleaveSource(lane, stride, lanes) == step) {
+      return (step == 0 ? 0 : lanes) + lane * stride % lanes;
+    }
+    return lane;
+  }
+
+  template <std::size_t step, std::size_t stride, std::size_t lanes, class V, std::size_t... Lane>
+  SPAN_ALWAYS_INLINE void DeinterleaveStep(V& gathered, const V& next, std::index_sequence<Lane...>) noexcept {
+    gathered = __builtin_shufflevector(gathered, next, DeinterleaveMask(step, Lane, stride, lanes)...);
+  }
+
+  // Writes every stride-th element of from[0, lanes * stride) to `to`.
+  // Vectors never cross a call boundary, hence the out-parameters.
+  template <class V, std::size_t stride, std::size_t lanes, class T>
+  SPAN_ALWAYS_INLINE void Deinterleave(T* to, const T* from) noexcept {
+    constexpr auto lane_indices = std::make_index_sequence<lanes>{};
+    V result = Load<V>(from);
+    DeinterleaveStep<0, stride, lanes>(result, result, lane_indices);
+    [&]<std::size_t... Step>(std::index_sequence<Step...>) {
+      (DeinterleaveStep<Step + 1, stride, lanes>(
+        result, Load<V>(from + (Step + 1) * lanes), lane_indices), ...);
+    }(std::make_index_sequence<stride - 1>{});
+    Store(to, result);
+  }
+
+  template <class T>
+  concept GatherElement = SimdElement<T> && (sizeof(T) == 4 || sizeof(T) == 8);
+
+  // Hardware gather/scatter helpers carry their own target attribute: the
+  // intrinsics cannot be inlined into the target-neutral kernel bodies.
+  // Each returns how many elements it handled.
+
+  template <class T>
+  SPAN_SIMD_TARGET("avx512f,avx512bw")
+  std::size_t GatherAvx512(const T* src, std::ptrdiff_t skip, T* dst, std::size_t size) {
+    std::size_t i = 0;
+#if SPAN_SIMD_X86
+    constexpr std::size_t lanes = 64 / sizeof(T);
+    const std::ptrdiff_t step = skip * static_cast<std::ptrdiff_t>(lanes);
+    if constexpr (sizeof(T) == 4) {
+      // Lane offsets are 32-bit for 4-byte elements.
+      if (skip > (1 << 26) || skip < -(1 << 26)) {
+        return 0;
+      }
+      const __m512i index = _mm512_mullo_epi32(
+        _mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15),
+        _mm512_set1_epi32(static_cast<int>(skip)));
+      for (; i + lanes <= size; i += lanes, src += step) {
+        _mm512_storeu_si512(dst + i, _mm512_i32gather_epi32(index, src, 4));
+      }
+    } else {
+      const __m512i index = _mm512_setr_epi64(
+        0, skip, 2 * skip, 3 * skip, 4 * skip, 5 * skip, 6 * skip, 7 * skip);
+      for (; i + lanes <= size; i += lanes, src += step) {
+        _mm512_storeu_si512(dst + i, _mm512_i64gather_epi64(index, src, 8));
+      }
+    }
+#endif
+    return i;
+  }
+
+  template <class T>
+  SPAN_SIMD_TARGET("avx2")
+  std::size_t GatherAvx2(const T* src, std::ptrdiff_t skip, T* dst, std::size_t size) {
+    std::size_t i = 0;
+#if SPAN_SIMD_X86
+    constexpr std::size_t lanes = 32 / sizeof(T);
+    const std::ptrdiff_t step = skip * static_cast<std::ptrdiff_t>(lanes);
+    if constexpr (sizeof(T) == 4) {
+      if (skip > (1 << 26) || skip < -(1 << 26)) {
+        return 0;
+      }
+      const __m256i index = _mm256_mullo_epi32(
+        _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7), _mm256_set1_epi32(static_cast<int>(skip)));
+      for (; i + lanes <= size; i += lanes, src += step) {
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i),
+          _mm256_i32gather_epi32(reinterpret_cast<const int*>(src), index, 4));
+      }
+    } else {
+      const __m256i index = _mm256_setr_epi64x(0, skip, 2 * skip, 3 * skip);
+      for (; i + lanes <= size; i += lanes, src += step) {
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i),
+          _mm256_i64gather_epi64(reinterpret_cast<const long long*>(src), index, 8));
+      }
+    }
+#endif
+    return i;
+  }
+
+  template <class T>
+  SPAN_SIMD_TARGET("avx512f,avx512bw")
+  std::size_t ScatterAvx512(const T* src, T* dst, std::ptrdiff_t skip, std::size_t size) {
+    std::size_t i = 0;
+#if SPAN_SIMD_X86
+    constexpr std::size_t lanes = 64 / sizeof(T);
+    const std::ptrdiff_t step = skip * static_cast<std::ptrdiff_t>(lanes);
+    if constexpr (sizeof(T) == 4) {
+      if (skip > (1 << 26) || skip < -(1 << 26)) {
+        return 0;
+      }
+      const __m512i index = _mm512_mullo_epi32(
+        _mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15),
+        _mm512_set1_epi32(static_cast<int>(skip)));
+      for (; i + lanes <= size; i += lanes, dst += step) {
+        _mm512_i32scatter_epi32(dst, index, _mm512_loadu_si512(src + i), 4);
+      }
+    } else {
+      const __m512i index = _mm512_setr_epi64(
+        0, skip, 2 * skip, 3 * skip, 4 * skip, 5 * skip, 6 * skip, 7 * skip);
+      for (; i + lanes <= size; i += lanes, dst += step) {
+        _mm512_i64scatter_epi64(dst, index, _mm512_loadu_si512(src + i), 8);
+      }
+    }
+#endif
+    return i;
+  }
+
+  template <class T, std::ptrdiff_t stride>
+  struct GatherKernel {
+    template <std::size_t bytes>
+    SPAN_ALWAYS_INLINE static void Run(const T* src, std::ptrdiff_t skip, T* dst, std::size_t size) {
+      std::size_t i = 0;
+      if constexpr (stride == 1) {
+        std::copy(src, src + size, dst);
+        return;
+      } else if constexpr (bytes != 0 && SimdElement<T> && stride > 1 && stride <= kMaxShuffleStride) {
+        using V = typename VectorOf<T, bytes>::Type;
+        constexpr std::size_t lanes = bytes / sizeof(T);
+        // The last block reads up to its (lanes * stride)-th element, so keep
+        // one element in reserve to never read past the slice.
+        for (; i + lanes < size; i += lanes) {
+          Deinterleave<V, stride, lanes>(dst + i, src + i * stride);
+        }
+      } else if constexpr (bytes == 64 && GatherElement<T>) {
+        i = GatherAvx512(src, skip, dst, size);
+      } else if constexpr (bytes == 32 && GatherElement<T>) {
+        i = GatherAvx2(src, skip, dst, size);
+      }
+      for (; i < size; ++i) {
+        dst[i] = src[static_cast<std::ptrdiff_t>(i) * skip];
+      }
+    }
+  };
+
+  template <class T, std::ptrdiff_t stride>
+  struct ScatterKernel {
+    template <std::size_t bytes>
+    SPAN_ALWAYS_INLINE static void Run(const T* src, T* dst, std::ptrdiff_t skip, std::size_t size) {
+      std::size_t i = 0;
+      if constexpr (stride == 1) {
+        std::copy(src, src + size, dst);
+        return;
+      }
+      if constexpr (bytes == 64 && GatherElement<T>) {
+        i = ScatterAvx512(src, dst, skip, size);
+      }
+      for (; i < size; ++i) {
+        dst[static_cast<std::ptrdiff_t>(i) * skip] = src[i];
+      }
+    }
+  };
+
+}
+
+#if defined(__GNUC__)
+#pragma GCC diagnostic pop
+#endif
+
+// dst[i] = src[i] for every element of src.
+template <class T, std::size_t extent, std::ptrdiff_t stride, std::size_t out_extent>
+void Gather(Slice<T, extent, stride> src, Span<std::remove_cv_t<T>, out_extent> dst) {
+  using V = std::remove_cv_t<T>;
+  assert(src.Size() <= dst.Size());
+  detail::Dispatch<detail::GatherKernel<V, stride>>(
+    static_cast<const V*>(src.Data()), src.Stride(), dst.Data(), src.Size());
+}
+
+// dst[i] = src[i] for every element of src.
+template <class T, std::size_t extent, class U, std::size_t out_extent, std::ptrdiff_t stride>
+requires std::same_as<std::remove_cv_t<T>, U>
+void Scatter(Span<T, extent> src, Slice<U, out_extent, stride> dst) {
+  assert(src.Size() <= dst.Size());
+  detail::Dispatch<detail::ScatterKernel<U, stride>>(
+    static_cast<const U*>(src.Data()), dst.Data(), dst.Stride(), src.Size());
+}
+
+// dst[i] = fn(src[i]). Both sides are strided; elements go through a small
+// contiguous buffer so that fn itself runs over dense memory and vectorises.
+template <class T, std::size_t extent, std::ptrdiff_t stride,
+          class U, std::size_t out_extent, std::ptrdiff_t out_stride, class F>
+requires (!std::is_const_v<U>) && std::invocable<F&, const std::remove_cv_t<T>&>
+void Transform(Slice<T, extent, stride> src, Slice<U, out_extent, out_stride> dst, F fn) {
+  using V = std::remove_cv_t<T>;
+  assert(src.Size() <= dst.Size());
+  if constexpr (std::is_trivially_copyable_v<V> && std::is_trivially_copyable_v<U> &&
+                std::is_default_constructible_v<V> && std::is_default_constructible_v<U>) {
+    constexpr std::size_t kBlock = 256;
+    V in[kBlock];
+    U out[kBlock];
+    for (std::size_t done = 0; done < src.Size(); done += kBlock) {
+      const std::size_t count = std::min(kBlock, src.Size() - done);
+      Gather(src.DropFirst(done).First(count), Span<V>(in, count));
+      for (std::size_t i = 0; i < count; ++i) {
+        out[i] = fn(in[i]);
+      }
+      Scatter(Span<const U>(out, count), dst.DropFirst(done).First(count));
+    }
+  } else {
+    for (std::size_t i = 0; i < src.Size(); ++i) {
+      dst[i] = fn(src[i]);
+    }
+  }
+}
@@ -0,0 +1,165 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cassert>
+#include <concepts>
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+
+#include <Slice.hpp>
+#include <Span.hpp>
+#include <SpanAlgorithms.hpp>
+
+// Transposition of row-major matrices stored in flat Spans.
+//
+// Column(matrix, row_length, j) describes column j as a Slice, which is all a
+// naive transpose needs: NaiveTranspose copies each source row into a column
+// of the destination. That walk strides through the whole destination for
+// every row and misses cache on almost every store once the matrix outgrows
+// L2.
+//
+// Transpose instead halves the longer side recursively (cache-oblivious)
+// until a leaf fits comfortably in L1, then moves the leaf in K x K register
+// blocks: K rows are loaded as vectors and transposed with log2(K) rounds of
+// two-input shuffles. K is the lane count of the widest available vector
+// capped at 16, i.e. 8x8 / 16x16 blocks of floats with AVX2 / AVX-512.
+
+template <class T, std::size_t extent>
+Slice<T, std::dynamic_extent, dynamic_stride>
+Column(Span<T, extent> matrix, std::size_t row_length, std::size_t col) {
+  assert(row_length > 0 && col < row_length);
+  return Slice<T, std::dynamic_extent, dynamic_stride>(matrix.Data(), matrix.Size(), 1)
+    .DropFirst(col)
+    .Skip(static_cast<std::ptrdiff_t>(row_length));
+}
+
+#if defined(__GNUC__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wpsabi"
+#endif
+
+namespace detail {
+
+  inline constexpr std::size_t kTransposeLeaf = 32;
+
+  // One butterfly round at distance `half`: row i (with bit `half` clear) and
+  // row i + half swap their off-diagonal half-blocks of width `half`.
+  constexpr std::size_t TransposeLowMask(std::size_t lane, std::size_t half, std::size_t lanes) {
+    return (lane & half) == 0 ? lane : lanes + lane - half;
+  }
+
+  constexpr std::size_t TransposeHighMask(std::size_t lane, std::size_t half, std::size_t lanes) {
+    return (lane & half) == 0 ? lane + half : lanes + lane;
+  }
+
+  template <std::size_t half, std::size_t lanes, class V, std::size_t... Lane>
+  SPAN_ALWAYS_INLINE void TransposeRound(V* rows, std::index_sequence<Lane...>) noexcept {
+    for (std::size_t i = 0; i < lanes; ++i) {
+      if ((i & half) == 0) {
+        const V low = rows[i];
+        const V high = rows[i + half];
+        rows[i] = __builtin_shufflevector(low, high, TransposeLowMask(Lane, half, lanes)...);
+        rows[i + half] = __builtin_shufflevector(low, high, TransposeHighMask(Lane, half, lanes)...);
+      }
+    }
+  }
+
+  template <class V, std::size_t lanes, class T>
+  SPAN_ALWAYS_INLINE void TransposeBlock(const T* src, std::size_t src_ld, T* dst, std::size_t dst_ld) noexcept {
+    V rows[lanes];
+    for (std::size_t i = 0; i < lanes; ++i) {
+      rows[i] = Load<V>(src + i * src_ld);
+    }
+    [&]<std::size_t... Round>(std::index_sequence<Round...>) {
+      (TransposeRound<(lanes >> (Round + 1)), lanes>(rows, std::make_index_sequence<lanes>{}), ...);
+    }(std::make_index_sequence<std::bit_width(lanes) - 1>{});
+    for (std::size_t i = 0; i < lanes; ++i) {
+      Store(dst + i * dst_ld, rows[i]);
+    }
+  }
+
+  template <class T>
+  SPAN_ALWAYS_INLINE void TransposeScalar(const T* src, std::size_t src_ld, T* dst, std::size_t dst_ld,
+                                          std::size_t rows, std::size_t cols) {
+    for (std::size_t r = 0; r < rows; ++r) {
+      for (std::size_t c = 0; c < cols; ++c) {
+        dst[c * dst_ld + r] = src[r * src_ld + c];
+      }
+    }
+  }
+
+  // A leaf of at most kTransposeLeaf x kTransposeLeaf elements.
+  template <class T>
+  struct TransposeLeafKernel {
+    template <std::size_t bytes>
+    SPAN_ALWAYS_INLINE static void Run(const T* src, std::size_t src_ld, T* dst, std::size_t dst_ld,
+                                       std::size_t rows, std::size_t cols) {
+      if constexpr (bytes != 0 && SimdElement<T> && bytes / sizeof(T) >= 2) {
+        constexpr std::size_t lanes = std::min<std::size_t>(bytes / sizeof(T), 16);
+        using V = typename VectorOf<T, lanes * sizeof(T)>::Type;
+        const std::size_t full_rows = rows - rows % lanes;
+        const std::size_t full_cols = cols - cols % lanes;
+        for (std::size_t r = 0; r < full_rows; r += lanes) {
+          for (std::size_t c = 0; c < full_cols; c += lanes) {
+            TransposeBlock<V, lanes>(src + r * src_ld + c, src_ld, dst + c * dst_ld + r, dst_ld);
+          }
+        }
+        // Right strip, then bottom strip.
+        TransposeScalar(src + full_cols, src_ld, dst + full_cols * dst_ld, dst_ld, full_rows, cols - full_cols);
+        TransposeScalar(src + full_rows * src_ld, src_ld, dst + full_rows, dst_ld, rows - full_rows, cols);
+      } else {
+        TransposeScalar(src, src_ld, dst, dst_ld, rows, cols);
+      }
+    }
+  };
+
+  template <class T>
+  void TransposeRecursive(const T* src, std::size_t src_ld, T* dst, std::size_t dst_ld,
+                          std::size_t rows, std::size_t cols) {
+    if (rows <= kTransposeLeaf && cols <= kTransposeLeaf) {
+      Dispatch<TransposeLeafKernel<T>>(src, src_ld, dst, dst_ld, rows, cols);
+      return;
+    }
+    // Split the longer side, keeping the cut on a leaf boundary so that
+    // register blocks stay whole.
+    if (rows >= cols) {
+      const std::size_t half = (rows / 2 + kTransposeLeaf - 1) / kTransposeLeaf * kTransposeLeaf;
+      TransposeRecursive(src, src_ld, dst, dst_ld, half, cols);
+      TransposeRecursive(src + half * src_ld, src_ld, dst + half, dst_ld, rows - half, cols);
+    } else {
+      const std::size_t half = (cols / 2 + kTransposeLeaf - 1) / kTransposeLeaf * kTransposeLeaf;
+      TransposeRecursive(src, src_ld, dst, dst_ld, rows, half);
+      TransposeRecursive(src + half, src_ld, dst + half * dst_ld, dst_ld, rows, cols - half);
+    }
+  }
+
+}
+
+#if defined(__GNUC__)
+#pragma GCC diagnostic pop
+#endif
+
+// dst (cols x rows, row-major) = transpose of src (rows x cols, row-major).
+// The two buffers must not overlap.
+template <class T, std::size_t extent, class U, std::size_t out_extent>
+requires std::same_as<std::remove_cv_t<T>, U>
+void Transpose(Span<T, extent> src, Span<U, out_extent> dst, std::size_t rows, std::size_t cols) {
+  assert(src.Size() >= rows * cols && dst.Size() >= rows * cols);
+  if (rows == 0 || cols == 0) {
+    return;
+  }
+  detail::TransposeRecursive<U>(src.Data(), cols, dst.Data(), rows, rows, cols);
+}
+
+// Reference implementation: one strided column store per source row.
+template <class T, std::size_t extent, class U, std::size_t out_extent>
+requires std::same_as<std::remove_cv_t<T>, U>
+void NaiveTranspose(Span<T, extent> src, Span<U, out_extent> dst, std::size_t rows, std::size_t cols) {
+  assert(src.Size() >= rows * cols && dst.Size() >= rows * cols);
+  for (std::size_t r = 0; r < rows; ++r) {
+    auto row = src.First((r + 1) * cols).Last(cols);
+    std::copy(row.begin(), row.end(), Column(dst, rows, r).begin());
+  }
+}
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <cstdint>
+#include <limits>
 #include <type_traits>
 #include <value_types.hpp>
 #include <type_lists.hpp>
@@ -12,40 +14,69 @@ using Increase = ValueTag<ValTag::Value + 1>;
 
 using type_lists::Cons;
 
-template<int Last, int New>
+// FibSeq<Prev, Cur> is the element Prev + Cur. The sum is checked and only
+// computed when that element is instantiated, so the sequence runs up to
+// the last Fibonacci number that fits into std::uint64_t and stops
+// compiling right after it.
+
+namespace fun_value_sequences::details {
+
+    consteval std::uint64_t FibAdd(std::uint64_t a, std::uint64_t b) {
+        if (a > std::numeric_limits<std::uint64_t>::max() - b) {
+            throw "Fib overflows std::uint64_t";
+        }
+        return a + b;
+    }
+
+}
+
+template<std::uint64_t Prev, std::uint64_t Cur>
 struct FibSeq {
-    using Head = ValueTag<Last>;
-    using Tail = FibSeq<New, Last + New>;
+    using Head = ValueTag<fun_value_sequences::details::FibAdd(Prev, Cur)>;
+    using Tail = FibSeq<Cur, Head::Value>;
 };
 
-template<int N, type_lists::TypeList PrimeS>
-struct IsPrime {
-    static constexpr int Res = 1;
-};
+// PrimesSeq<N> goes from the prime N straight to the next one. The search
+// runs in a constexpr loop over the 6k +- 1 wheel with trial divisors up to
+// the square root, so there is one instantiation per prime and the type of
+// each element does not depend on the ones before it.
 
-template<int N, type_lists::TypeSequence PrimeS>
-struct IsPrime<N, PrimeS> {
-    static constexpr int Res = 0; 
-};
+namespace fun_value_sequences::details {
 
-template<int N, type_lists::TypeSequence PrimeS>
-requires(N % PrimeS::Head::Value != 0)
-struct IsPrime<N, PrimeS> {
-    static constexpr int Res = IsPrime<N, typename PrimeS::Tail>::Res;
-};
+    constexpr bool IsPrime(int n) {
+        if (n < 2) {
+            return false;
+        }
+        if (n % 2 == 0 || n % 3 == 0) {
+            return n < 4;
+        }
+        for (int d = 5; d <= n / d; d += 6) {
+            if (n % d == 0 || n % (d + 2) == 0) {
+                return false;
+            }
+        }
+        return true;
+    }
 
-template<int N, type_lists::TypeList PrevPrimesSeq>
-struct PrimesSeq
-    : PrimesSeq<N + 1, PrevPrimesSeq> {};
+    constexpr int NextPrime(int n) {
+        if (n < 3) {
+            return n + 1;
+        }
+        int candidate = n % 2 == 0 ? n + 1 : n + 2;
+        while (!IsPrime(candidate)) {
+            candidate += 2;
+        }
+        return candidate;
+    }
 
-template<int N, type_lists::TypeList PrevPrimesSeq>
-requires(IsPrime<N, PrevPrimesSeq>::Res == 1)
-struct PrimesSeq<N, PrevPrimesSeq> { 
+}
+
+template<int N>
+struct PrimesSeq {
     using Head = ValueTag<N>;
-    using Tail = PrimesSeq<N + 1, Cons<ValueTag<N>, PrevPrimesSeq>>;
+    using Tail = PrimesSeq<fun_value_sequences::details::NextPrime(N)>;
 };
 
 using Nats = Iterate<Increase, ValueTag<0>>;
-using Fib = FibSeq<0, 1>;
-using Primes = PrimesSeq<2, type_lists::Nil>;
-
+using Fib = Cons<ValueTag<std::uint64_t{0}>, FibSeq<1, 0>>;
+using Primes = PrimesSeq<2>;
@@ -0,0 +1,140 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <type_tuples.hpp>
+
+namespace type_tuples {
+
+// PackedTuple<Ts...> -- тюпл значений, члены которого лежат в памяти по убыванию выравнивания,
+// а get<I> по-прежнему нумерует их в порядке объявления.
+// Sizes are multiples of alignments, so with alignments descending every
+// member lands right after the previous one and only the tail is padded.
+
+namespace details {
+
+    template<class T>
+    struct PackingKey {
+        static constexpr std::ptrdiff_t Value = -static_cast<std::ptrdiff_t>(alignof(T));
+    };
+
+    // Value-initialized by default, like the members of std::tuple, and
+    // direct-initialized (never brace-initialized) from an argument, so
+    // that exactly the constructible_from conversions are accepted.
+    template<std::size_t Slot, class T>
+    struct PackedLeaf {
+        PackedLeaf() : value() {}
+
+        template<class Arg>
+        PackedLeaf(std::in_place_t, Arg&& arg) : value(std::forward<Arg>(arg)) {}
+
+        [[no_unique_address]] T value;
+    };
+
+    // Members are bases, laid out in storage order. Order[Slot] is the
+    // declaration index of the member stored in Slot.
+    template<class Order, class Seq, class... Us>
+    struct PackedStorage;
+
+    template<class Order, std::size_t... Slots, class... Us>
+    struct PackedStorage<Order, std::index_sequence<Slots...>, Us...>
+        : PackedLeaf<Slots, Us>... {
+        PackedStorage() = default;
+
+        template<class Refs>
+        explicit PackedStorage(Refs&& refs)
+            : PackedLeaf<Slots, Us>(std::in_place, std::get<Order::kValue[Slots]>(std::move(refs)))... {}
+    };
+
+    template<class... Ts>
+    struct PackedLayout {
+        using Order = SortPermutation<PackingKey, TTuple<Ts...>>;
+
+        static constexpr std::array<std::size_t, sizeof...(Ts)> kSlots = [] {
+            std::array<std::size_t, sizeof...(Ts)> slots{};
+            for (std::size_t slot = 0; slot < slots.size(); ++slot) {
+                slots[Order::kValue[slot]] = slot;
+            }
+            return slots;
+        }();
+
+        template<class TT>
+        struct StorageFor;
+
+        template<class... Us>
+        struct StorageFor<TTuple<Us...>> {
+            using Type = PackedStorage<Order, std::index_sequence_for<Us...>, Us...>;
+        };
+
+        using Storage = typename StorageFor<SortBy<PackingKey, TTuple<Ts...>>>::Type;
+    };
+
+}
+
+template<class... Ts>
+class PackedTuple {
+    using Layout = details::PackedLayout<Ts...>;
+
+public:
+    PackedTuple() = default;
+
+    template<class... Args>
+    requires (sizeof...(Args) == sizeof...(Ts) && sizeof...(Ts) > 0 && (std::constructible_from<Ts, Args&&> && ...))
+    explicit PackedTuple(Args&&... args)
+        : storage_(std::forward_as_tuple(std::forward<Args>(args)...)) {}
+
+    template<std::size_t I>
+    auto& Get() & {
+        return Leaf<I>(storage_).value;
+    }
+
+    template<std::size_t I>
+    const auto& Get() const & {
+        return Leaf<I>(storage_).value;
+    }
+
+    template<std::size_t I>
+    auto&& Get() && {
+        return std::move(Leaf<I>(storage_).value);
+    }
+
+private:
+    template<std::size_t I>
+    using Element = type_tuples::Get<I, TTuple<Ts...>>;
+
+    template<std::size_t I, class S>
+    static auto& Leaf(S& storage) {
+        using L = details::PackedLeaf<Layout::kSlots[I], Element<I>>;
+        return static_cast<std::conditional_t<std::is_const_v<S>, const L&, L&>>(storage);
+    }
+
+    typename Layout::Storage storage_;
+};
+
+template<std::size_t I, class... Ts>
+decltype(auto) get(PackedTuple<Ts...>& tuple) {
+    return tuple.template Get<I>();
+}
+
+template<std::size_t I, class... Ts>
+decltype(auto) get(const PackedTuple<Ts...>& tuple) {
+    return tuple.template Get<I>();
+}
+
+template<std::size_t I, class... Ts>
+decltype(auto) get(PackedTuple<Ts...>&& tuple) {
+    return std::move(tuple).template Get<I>();
+}
+
+}
+
+template<class... Ts>
+struct std::tuple_size<type_tuples::PackedTuple<Ts...>>
+    : std::integral_constant<std::size_t, sizeof...(Ts)> {};
+
+template<std::size_t I, class... Ts>
+struct std::tuple_element<I, type_tuples::PackedTuple<Ts...>> {
+    using type = type_tuples::Get<I, type_tuples::TTuple<Ts...>>;
+};
@@ -0,0 +1,150 @@
+#pragma once
+#include <array>
+#include <cassert>
+#include <concepts>
+#include <cstddef>
+#include <functional>
+#include <type_traits>
+#include <utility>
+#include <type_lists.hpp>
+#include <type_tuples.hpp>
+
+namespace type_lists {
+
+// Dispatch<TL>(index, visitor) -- visitor(std::type_identity<T>{}) для index-ого типа T
+// конечного списка или тюпла TL.
+// Visit<TLs...>(visitor, indices...) -- то же сразу для нескольких списков, как std::visit.
+
+namespace details {
+
+    template<class TL>
+    struct AsTupleImpl {
+        using Type = ToTuple<TL>;
+    };
+
+    template<type_tuples::TypeTuple TT>
+    struct AsTupleImpl<TT> {
+        using Type = TT;
+    };
+
+    template<class TL>
+    using AsTuple = typename AsTupleImpl<TL>::Type;
+
+    template<class TT>
+    struct TupleSize;
+
+    template<class... Ts>
+    struct TupleSize<type_tuples::TTuple<Ts...>>
+        : std::integral_constant<std::size_t, sizeof...(Ts)> {};
+
+    // The alternatives of all lists are numbered row-major, so a tuple of
+    // indices becomes one flat index into a single table.
+    template<class... TTs>
+    struct Grid {
+        static constexpr std::size_t kRank = sizeof...(TTs);
+        static constexpr std::array<std::size_t, kRank> kSizes{TupleSize<TTs>::value...};
+        static constexpr std::size_t kCount = (TupleSize<TTs>::value * ... * 1);
+
+        static constexpr std::size_t Stride(std::size_t k) {
+            std::size_t stride = 1;
+            for (std::size_t i = k + 1; i < kRank; ++i) {
+                stride *= kSizes[i];
+            }
+            return stride;
+        }
+
+        static constexpr std::size_t Component(std::size_t k, std::size_t flat) {
+            return flat / Stride(k) % kSizes[k];
+        }
+
+        template<class... Is>
+        static constexpr std::size_t Flatten(Is... indices) {
+            std::size_t flat = 0;
+            std::size_t k = 0;
+            ((assert(static_cast<std::size_t>(indices) < kSizes[k]),
+              flat = flat * kSizes[k] + static_cast<std::size_t>(indices), ++k), ...);
+            return flat;
+        }
+    };
+
+    template<class Visitor, class Grid, class Seq>
+    struct Invoker;
+
+    template<class Visitor, class... TTs, std::size_t... Ks>
+    struct Invoker<Visitor, Grid<TTs...>, std::index_sequence<Ks...>> {
+        template<std::size_t Flat>
+        using Result = std::invoke_result_t<Visitor,
+            std::type_identity<type_tuples::Get<Grid<TTs...>::Component(Ks, Flat), TTs>>...>;
+
+        template<class R, std::size_t Flat>
+        static R Call(Visitor&& visitor) {
+            return std::invoke(std::forward<Visitor>(visitor),
+                std::type_identity<type_tuples::Get<Grid<TTs...>::Component(Ks, Flat), TTs>>{}...);
+        }
+    };
+
+    // Small tables are a switch the compiler lowers as it sees fit, larger
+    // ones a constexpr array of thunks indexed directly.
+    inline constexpr std::size_t kSwitchLimit = 4;
+
+    template<class Visitor, class Grid, class Seq = std::make_index_sequence<Grid::kCount>>
+    struct DispatchTable;
+
+    template<class Visitor, class... TTs, std::size_t... Fs>
+    struct DispatchTable<Visitor, Grid<TTs...>, std::index_sequence<Fs...>> {
+        using Inv = Invoker<Visitor, Grid<TTs...>, std::index_sequence_for<TTs...>>;
+        using R = typename Inv::template Result<0>;
+
+        static_assert((std::same_as<typename Inv::template Result<Fs>, R> && ...),
+            "all alternatives must return the same type");
+
+        static constexpr std::array<R (*)(Visitor&&), sizeof...(Fs)> kTable{
+            &Inv::template Call<R, Fs>...};
+
+        static R Run(std::size_t flat, Visitor&& visitor) {
+            constexpr std::size_t kCount = sizeof...(Fs);
+            if constexpr (kCount <= kSwitchLimit) {
+                switch (flat) {
+                    case 0:
+                        return Inv::template Call<R, 0>(std::forward<Visitor>(visitor));
+                    case 1:
+                        if constexpr (kCount > 1) {
+                            return Inv::template Call<R, 1>(std::forward<Visitor>(visitor));
+                        }
+                        break;
+                    case 2:
+                        if constexpr (kCount > 2) {
+                            return Inv::template Call<R, 2>(std::forward<Visitor>(visitor));
+                        }
+                        break;
+                    case 3:
+                        if constexpr (kCount > 3) {
+                            return Inv::template Call<R, 3>(std::forward<Visitor>(visitor));
+                        }
+                        break;
+                }
+                assert(false && "dispatch index out of range");
+                __builtin_unreachable();
+            } else {
+                return kTable[flat](std::forward<Visitor>(visitor));
+            }
+        }
+    };
+
+}
+
+template<class... TLs, class Visitor, std::convertible_to<std::size_t>... Is>
+requires (sizeof...(TLs) > 0 && sizeof...(TLs) == sizeof...(Is))
+decltype(auto) Visit(Visitor&& visitor, Is... indices) {
+    using Grid = details::Grid<details::AsTuple<TLs>...>;
+    static_assert(Grid::kCount > 0, "cannot dispatch over an empty list");
+    return details::DispatchTable<Visitor, Grid>::Run(
+        Grid::Flatten(indices...), std::forward<Visitor>(visitor));
+}
+
+template<class TL, class Visitor>
+decltype(auto) Dispatch(std::size_t index, Visitor&& visitor) {
+    return Visit<TL>(std::forward<Visitor>(visitor), index);
+}
+
+}
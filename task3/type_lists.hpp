@@ -1,5 +1,7 @@
 #pragma once
 #include <concepts>
+#include <cstddef>
+#include <type_traits>
 #include <type_tuples.hpp>
 
 namespace type_lists {
@@ -20,11 +22,67 @@ concept TypeList = Empty<TL> || TypeSequence<TL>;
 
 namespace details {
 
-template<TypeList TL>
-constexpr std::size_t Length = 0;
+// Walking a list costs at least one instantiation per element, but the
+// nesting depth need not grow with it. DropImpl advances in blocks of
+// kDropBlock elements and splits longer distances in halves, so its depth
+// is O(log N); it stops early at the end of a finite list.
 
-template<TypeSequence TS>
-constexpr std::size_t Length<TS> = 1 + Length<typename TS::Tail>;
+inline constexpr std::size_t kDropBlock = 8;
+
+template<std::size_t N, class TL>
+concept DropsBlock = N == kDropBlock && requires {
+    typename TL::Tail::Tail::Tail::Tail::Tail::Tail::Tail::Tail;
+};
+
+template<std::size_t N, class TL>
+concept DropsHalves = N > 1 && !DropsBlock<N, TL>;
+
+constexpr std::size_t DropSplit(std::size_t n) {
+    return n > kDropBlock ? kDropBlock * ((n / kDropBlock + 1) / 2) : n / 2;
+}
+
+template<std::size_t N, TypeList TL>
+struct DropImpl {
+    using Type = TL;
+};
+
+template<std::size_t N, TypeSequence TS>
+requires (N == 1)
+struct DropImpl<N, TS> {
+    using Type = typename TS::Tail;
+};
+
+template<std::size_t N, TypeSequence TS>
+requires DropsBlock<N, TS>
+struct DropImpl<N, TS> {
+    using Type = typename TS::Tail::Tail::Tail::Tail::Tail::Tail::Tail::Tail;
+};
+
+template<std::size_t N, TypeSequence TS>
+requires DropsHalves<N, TS>
+struct DropImpl<N, TS> {
+    static constexpr std::size_t kLeft = DropSplit(N);
+    using Type = typename DropImpl<N - kLeft, typename DropImpl<kLeft, TS>::Type>::Type;
+};
+
+// Galloping count: blocks double while the list lasts, then halve to pin
+// down the remainder, so there are O(log N) nested steps.
+template<TypeList TL, std::size_t Block, bool Growing>
+consteval std::size_t CountFrom() {
+    if constexpr (Block == 0 || Empty<TL>) {
+        return 0;
+    } else {
+        using Last = typename DropImpl<Block - 1, TL>::Type;
+        if constexpr (TypeSequence<Last>) {
+            return Block + CountFrom<typename Last::Tail, (Growing ? 2 * Block : Block / 2), Growing>();
+        } else {
+            return CountFrom<TL, Block / 2, false>();
+        }
+    }
+}
+
+template<TypeList TL>
+constexpr std::size_t Length = CountFrom<TL, 1, true>();
 
 };
 
@@ -40,34 +98,86 @@ struct Cons {
 
 namespace details {
 
+    // Lists are assembled from a pack by a fold expression: a right fold
+    // conses the elements in order, a left fold conses them reversed. Either
+    // way it is one step per element and no recursion of our own.
+
+    template<TypeList TL>
+    struct ConsBuilder {
+        using Type = TL;
+    };
+
+    template<class T, TypeList TL>
+    ConsBuilder<Cons<T, TL>> operator>>(std::type_identity<T>, ConsBuilder<TL>);
+
+    template<TypeList TL, class T>
+    ConsBuilder<Cons<T, TL>> operator<<(ConsBuilder<TL>, std::type_identity<T>);
+
     template<class TT>
     struct FromTupleImpl;
 
-    template<class T, class... Ts>
-    struct FromTupleImpl<typename type_tuples::TTuple<T, Ts...>> {
-        using Type = Cons<T, typename FromTupleImpl<typename type_tuples::TTuple<Ts...>>::Type>;
+    template<class... Ts>
+    struct FromTupleImpl<type_tuples::TTuple<Ts...>> {
+        using Type = typename decltype((std::type_identity<Ts>{} >> ... >> ConsBuilder<Nil>{}))::Type;
     };
 
-    template<>
-    struct FromTupleImpl<typename type_tuples::TTuple<>> {
-        using Type = Nil;
+    template<class TT>
+    struct ReverseTupleImpl;
+
+    template<class... Ts>
+    struct ReverseTupleImpl<type_tuples::TTuple<Ts...>> {
+        using Type = typename decltype((ConsBuilder<Nil>{} << ... << std::type_identity<Ts>{}))::Type;
     };
 
     using type_tuples::TTuple;
     using type_tuples::TypeTuple;
-    template<TypeList TL, TypeTuple TT = TTuple<>>
-    struct ToTupleImpl;
-    
-    template<Empty E, TypeTuple TT>
-    struct ToTupleImpl<E, TT> {
-        using Type = TT;
+
+    // TakeTuple<N, TL> -- up to N first elements of TL as a tuple (Type) and
+    // the list that follows them (Rest). Halves are built separately and
+    // concatenated, leaves take four elements at once: O(log N) depth.
+
+    template<class TL>
+    concept HasFour = requires {
+        typename TL::Tail::Tail::Tail::Head;
     };
 
-    template<TypeSequence TS, TypeTuple TT>
-    struct ToTupleImpl<TS, TT> {
-        using Type = type_tuples::Prepend
-            < typename ToTupleImpl<typename TS::Tail, TT>::Type
-            , typename TS::Head>;
+    template<std::size_t N, TypeList TL>
+    struct TakeTuple {
+        using Type = TTuple<>;
+        using Rest = TL;
+    };
+
+    template<std::size_t N, TypeSequence TS>
+    requires (N == 1)
+    struct TakeTuple<N, TS> {
+        using Type = TTuple<typename TS::Head>;
+        using Rest = typename TS::Tail;
+    };
+
+    template<std::size_t N, TypeSequence TS>
+    requires (N == 4 && HasFour<TS>)
+    struct TakeTuple<N, TS> {
+        using Type = TTuple
+            < typename TS::Head
+            , typename TS::Tail::Head
+            , typename TS::Tail::Tail::Head
+            , typename TS::Tail::Tail::Tail::Head>;
+        using Rest = typename TS::Tail::Tail::Tail::Tail;
+    };
+
+    template<std::size_t N, TypeSequence TS>
+    requires (N > 1 && !(N == 4 && HasFour<TS>))
+    struct TakeTuple<N, TS> {
+        static constexpr std::size_t kLeft = N > 4 ? 4 * ((N / 4 + 1) / 2) : N / 2;
+        using Left = TakeTuple<kLeft, TS>;
+        using Right = TakeTuple<N - kLeft, typename Left::Rest>;
+        using Type = type_tuples::Concat<typename Left::Type, typename Right::Type>;
+        using Rest = typename Right::Rest;
+    };
+
+    template<TypeList TL>
+    struct ToTupleImpl {
+        using Type = typename TakeTuple<Length<TL>, TL>::Type;
     };
 
 }
@@ -99,19 +209,18 @@ struct Take<N, TS> {
     using Tail = Take<N - 1, typename TS::Tail>;
 };
 
+// Converting a prefix needs no walk over the Take nodes themselves, and the
+// source may be infinite.
+template<std::size_t N, TypeList TL>
+struct details::ToTupleImpl<Take<N, TL>> {
+    using Type = typename TakeTuple<N, TL>::Type;
+};
+
 // Drop<N, TL> -- всё кроме первых N элементов списка TL.
 
 template<std::size_t N, TypeList TL>
 struct Drop
-    : Nil {};
-
-template<std::size_t N, TypeSequence TS>
-struct Drop<N, TS>
-    : Drop<N - 1, typename TS::Tail> {};
-
-template<TypeSequence TS>
-struct Drop<0, TS>
-    : TS {};
+    : details::DropImpl<N, TL>::Type {};
 
 // Replicate<N, T> -- список из N элементов равных T.
 
@@ -261,16 +370,29 @@ struct Scanl<OP, T, TS>
 
 namespace details {
 
-template<template<class, class> class OP, class T, TypeList TL>
-struct FoldlImpl {
+// The list is flattened into a pack once and folded with a fold expression,
+// so OP is applied without any recursion of our own.
+
+template<template<class, class> class OP, class T>
+struct FoldlStep {
     using Type = T;
 };
 
-template<template<class, class> class OP, class T, TypeSequence TS>
-struct FoldlImpl<OP, T, TS> {
-    using Type = FoldlImpl<OP, OP<T, typename TS::Head>, typename TS::Tail>::Type;
+template<template<class, class> class OP, class T, class U>
+FoldlStep<OP, OP<T, U>> operator+(FoldlStep<OP, T>, std::type_identity<U>);
+
+template<template<class, class> class OP, class T, class TT>
+struct FoldlTuple;
+
+template<template<class, class> class OP, class T, class... Ts>
+struct FoldlTuple<OP, T, type_tuples::TTuple<Ts...>> {
+    using Type = typename decltype((FoldlStep<OP, T>{} + ... + std::type_identity<Ts>{}))::Type;
 };
 
+template<template<class, class> class OP, class T, TypeList TL>
+struct FoldlImpl
+    : FoldlTuple<OP, T, typename ToTupleImpl<TL>::Type> {};
+
 }
 
 template<template<class, class> class OP, class T, TypeList TL>
@@ -306,36 +428,99 @@ struct Zip<Ts...>
     : Nil {};
 
 
-// Бонусный уровень(+1 балл):
-// GroupBy<EQ, TL> --список из списков подряд идущих элементов TL, "равных" последовательно
+// Append<T, TL> -- ленивое добавление T в конец TL; для бесконечного TL это сам TL.
+// Concat<L, R> / AppendFinite<T, TL> / Reverse<TL> -- конкатенация, добавление в конец и разворот конечных списков.
+// These are built eagerly from the flattened lists, so their cost is linear
+// in the length of the result, however the arguments were produced.
 
 template<class T, TypeList TL>
 struct Append
     : Cons<T, Nil> {};
 
+// Not built on Cons: its TypeList check on the tail would walk the whole
+// list and never finish on an infinite one.
 template<class T, TypeSequence TS>
-struct Append<T, TS>
-    : Cons<typename TS::Head, Append<T, typename TS::Tail>> {};
+struct Append<T, TS> {
+    using Head = typename TS::Head;
+    using Tail = Append<T, typename TS::Tail>;
+};
+
+namespace details {
+
+    template<TypeList L, TypeList R>
+    struct ConcatImpl {
+        using Type = typename FromTupleImpl<type_tuples::Concat<ToTuple<L>, ToTuple<R>>>::Type;
+    };
+
+}
+
+template<TypeList L, TypeList R>
+using Concat = typename details::ConcatImpl<L, R>::Type;
+
+template<class T, TypeList TL>
+using AppendFinite = Concat<TL, Cons<T, Nil>>;
+
+template<TypeList TL>
+using Reverse = typename details::ReverseTupleImpl<ToTuple<TL>>::Type;
+
+// SortBy<Key, TL> -- конечный список TL, устойчиво отсортированный по возрастанию Key<_>::Value.
+
+template<template<class> class Key, TypeList TL>
+using SortBy = FromTuple<type_tuples::SortBy<Key, ToTuple<TL>>>;
+
+// Бонусный уровень(+1 балл):
+// GroupBy<EQ, TL> --список из списков подряд идущих элементов TL, "равных" последовательно
+
+namespace details {
+
+// A group is measured once against its first element and then taken in one
+// piece, and the next group starts right after it: every element is visited
+// a constant number of times. Runs are scanned four elements per step.
+
+template<template<class, class> class EQ, class First, TypeList TL>
+consteval std::size_t RunLength() {
+    if constexpr (Empty<TL>) {
+        return 0;
+    } else if constexpr (HasFour<TL>) {
+        constexpr bool kSame[] = {
+            EQ<First, typename TL::Head>::Value,
+            EQ<First, typename TL::Tail::Head>::Value,
+            EQ<First, typename TL::Tail::Tail::Head>::Value,
+            EQ<First, typename TL::Tail::Tail::Tail::Head>::Value,
+        };
+        if constexpr (kSame[0] && kSame[1] && kSame[2] && kSame[3]) {
+            return 4 + RunLength<EQ, First, typename TL::Tail::Tail::Tail::Tail>();
+        } else {
+            std::size_t n = 0;
+            while (kSame[n]) {
+                ++n;
+            }
+            return n;
+        }
+    } else if constexpr (EQ<First, typename TL::Head>::Value) {
+        return 1 + RunLength<EQ, First, typename TL::Tail>();
+    } else {
+        return 0;
+    }
+}
+
+template<template<class, class> class EQ, TypeSequence TS>
+struct Group {
+    static constexpr std::size_t kLength = 1 + RunLength<EQ, typename TS::Head, typename TS::Tail>();
+    using Type = typename FromTupleImpl<typename TakeTuple<kLength, TS>::Type>::Type;
+    using Rest = typename DropImpl<kLength, TS>::Type;
+};
+
+}
 
-template<template<class, class> class EQ, TypeList TL, TypeList TR = Nil>
+template<template<class, class> class EQ, TypeList TL>
 struct GroupBy
     : Nil {};
 
-template<template<class, class> class EQ, Empty E, TypeList TR>
-requires (!Empty<TR>)
-struct GroupBy<EQ, E, TR>
-    : Cons<TR, Nil> {};
-
-template<template<class, class> class EQ, TypeSequence TS, TypeList TR>
-requires (Empty<TR> || EQ<typename TR::Head, typename TS::Head>::Value)
-struct GroupBy<EQ, TS, TR>
-    : GroupBy<EQ, typename TS::Tail, Append<typename TS::Head, TR>> {};
-
-template<template<class, class> class EQ, TypeSequence TS, TypeList TR>
-    requires (!EQ<typename TR::Head, typename TS::Head>::Value)
-struct GroupBy<EQ, TS, TR> {
-    using Head = TR;
-    using Tail = GroupBy<EQ, TS>;
+template<template<class, class> class EQ, TypeSequence TS>
+struct GroupBy<EQ, TS> {
+    using Head = typename details::Group<EQ, TS>::Type;
+    using Tail = GroupBy<EQ, typename details::Group<EQ, TS>::Rest>;
 };
 
 }
@@ -1,5 +1,9 @@
 #pragma once
 
+#include <array>
+#include <cstddef>
+#include <utility>
+
 
 namespace type_tuples
 {
@@ -10,16 +14,115 @@ struct TTuple {};
 template<class TT>
 concept TypeTuple = requires(TT t) { []<class... Ts>(TTuple<Ts...>){}(t); };
 
+namespace details {
+
+    // Plain partial specializations rather than lambdas in decltype: GCC
+    // rejects the latter inside alias templates.
+
+    template<class TT, class T>
+    struct PrependImpl;
+
+    template<class... Ts, class T>
+    struct PrependImpl<TTuple<Ts...>, T> {
+        using Type = TTuple<T, Ts...>;
+    };
+
+    template<class TT, class T>
+    struct AppendImpl;
+
+    template<class... Ts, class T>
+    struct AppendImpl<TTuple<Ts...>, T> {
+        using Type = TTuple<Ts..., T>;
+    };
+
+    template<class L, class R>
+    struct ConcatImpl;
+
+    template<class... Ls, class... Rs>
+    struct ConcatImpl<TTuple<Ls...>, TTuple<Rs...>> {
+        using Type = TTuple<Ls..., Rs...>;
+    };
+
+    // Indexing by overload resolution: the pack is spread over the bases of
+    // one class and Select<I> picks the only base tagged with I. No
+    // recursion over the pack at all.
+
+    template<std::size_t I, class T>
+    struct Indexed {
+        using Type = T;
+    };
+
+    template<class Seq, class... Ts>
+    struct IndexedPack;
+
+    template<std::size_t... Is, class... Ts>
+    struct IndexedPack<std::index_sequence<Is...>, Ts...>
+        : Indexed<Is, Ts>... {};
+
+    template<std::size_t I, class T>
+    Indexed<I, T> Select(const Indexed<I, T>&);
+
+    template<std::size_t I, class TT>
+    struct GetImpl;
+
+    template<std::size_t I, class... Ts>
+    requires (I < sizeof...(Ts))
+    struct GetImpl<I, TTuple<Ts...>> {
+        using Type = typename decltype(
+            Select<I>(std::declval<IndexedPack<std::index_sequence_for<Ts...>, Ts...>>()))::Type;
+    };
+
+    // Stable sort of the positions by key: the keys are evaluated once into
+    // an array and ordered by a constexpr insertion sort, then the tuple is
+    // rebuilt by indexing. No recursion over the pack.
+
+    template<template<class> class Key, class TT>
+    struct SortPermutation;
+
+    template<template<class> class Key, class... Ts>
+    struct SortPermutation<Key, TTuple<Ts...>> {
+        static constexpr std::array<std::size_t, sizeof...(Ts)> kValue = [] {
+            using KeyType = decltype((Key<Ts>::Value + ... + 0));
+            std::array<KeyType, sizeof...(Ts)> keys{static_cast<KeyType>(Key<Ts>::Value)...};
+            std::array<std::size_t, sizeof...(Ts)> order{};
+            for (std::size_t i = 0; i < order.size(); ++i) {
+                std::size_t j = i;
+                for (; j > 0 && keys[i] < keys[order[j - 1]]; --j) {
+                    order[j] = order[j - 1];
+                }
+                order[j] = i;
+            }
+            return order;
+        }();
+    };
+
+    template<template<class> class Key, class TT, class Seq>
+    struct SortByImpl;
+
+    template<template<class> class Key, class... Ts, std::size_t... Is>
+    struct SortByImpl<Key, TTuple<Ts...>, std::index_sequence<Is...>> {
+        using Type = TTuple<typename GetImpl<SortPermutation<Key, TTuple<Ts...>>::kValue[Is], TTuple<Ts...>>::Type...>;
+    };
+
+} // namespace details
+
 template<TypeTuple TT, typename T>
-using Prepend =
-decltype([]<class... Ts>(TTuple<Ts...>) {
-    return TTuple<T, Ts...>{};
-} (TT{}));
+using Prepend = typename details::PrependImpl<TT, T>::Type;
 
 template<TypeTuple TT, typename T>
-using Append =
-decltype([]<class... Ts>(TTuple<Ts...>) {
-    return TTuple<Ts..., T>{};
-} (TT{}));
+using Append = typename details::AppendImpl<TT, T>::Type;
+
+template<TypeTuple L, TypeTuple R>
+using Concat = typename details::ConcatImpl<L, R>::Type;
+
+// Get<I, TT> -- I-ый тип тюпла.
+
+template<std::size_t I, TypeTuple TT>
+using Get = typename details::GetImpl<I, TT>::Type;
+
+// SortBy<Key, TT> -- тюпл TT, устойчиво отсортированный по возрастанию Key<_>::Value.
+
+template<template<class> class Key, TypeTuple TT>
+using SortBy = typename details::SortByImpl<Key, TT, std::make_index_sequence<details::SortPermutation<Key, TT>::kValue.size()>>::Type;
 
 } // namespace type_tuples
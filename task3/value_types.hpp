@@ -1,5 +1,9 @@
 #pragma once
+#include <array>
+#include <cstddef>
+#include <type_traits>
 #include <type_tuples.hpp>
+#include <type_lists.hpp>
 
 
 namespace value_types
@@ -11,4 +15,64 @@ struct ValueTag{ static constexpr auto Value = V; };
 template<class T, T... ts>
 using VTuple = type_tuples::TTuple<ValueTag<ts>...>;
 
+// ToArray<VT> -- значения тюпла из ValueTag в виде constexpr std::array.
+// TakeArray<N, TL> -- то же для первых N элементов потенциально бесконечного списка TL.
+// Each distinct table is a single inline constexpr object, so it is emitted
+// once and indexed at run time without touching the type-level sequence.
+
+namespace details {
+
+    // std::common_type recurses once per argument; folding it pairwise keeps
+    // long tables within the template depth limit.
+
+    template<class T>
+    struct CommonStep {
+        using Type = T;
+    };
+
+    template<class T, class U>
+    CommonStep<std::common_type_t<T, U>> operator+(CommonStep<T>, std::type_identity<U>);
+
+    // Empty is the element type of an empty table, which has no values to
+    // take it from.
+    template<class VT, class Empty = int>
+    struct ToArrayImpl;
+
+    template<class Empty>
+    struct ToArrayImpl<type_tuples::TTuple<>, Empty> {
+        static constexpr std::array<Empty, 0> kValue{};
+    };
+
+    template<class T, class... Ts, class Empty>
+    struct ToArrayImpl<type_tuples::TTuple<T, Ts...>, Empty> {
+        using Element = typename decltype((CommonStep<std::remove_cv_t<decltype(T::Value)>>{} + ...
+            + std::type_identity<std::remove_cv_t<decltype(Ts::Value)>>{}))::Type;
+        static constexpr std::array<Element, 1 + sizeof...(Ts)> kValue{
+            static_cast<Element>(T::Value), static_cast<Element>(Ts::Value)...};
+    };
+
+    // TakeArray<0, TL> keeps the value type of TL's head when there is one.
+    template<class TL>
+    struct HeadValue {
+        using Type = int;
+    };
+
+    template<type_lists::TypeSequence TS>
+    struct HeadValue<TS> {
+        using Type = std::remove_cv_t<decltype(TS::Head::Value)>;
+    };
+
+}
+
+template<type_tuples::TypeTuple VT>
+inline constexpr const auto& ToArray = details::ToArrayImpl<VT>::kValue;
+
+template<std::size_t N, type_lists::TypeList TL>
+inline constexpr const auto& TakeArray =
+    details::ToArrayImpl<type_lists::ToTuple<type_lists::Take<N, TL>>, typename details::HeadValue<TL>::Type>::kValue;
+
+static_assert(ToArray<type_tuples::TTuple<>>.empty());
+static_assert(TakeArray<0, type_lists::Nil>.empty());
+static_assert(TakeArray<2, type_lists::FromTuple<VTuple<int, 1, 2, 3>>>[1] == 2);
+
 }
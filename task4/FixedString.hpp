@@ -1,12 +1,148 @@
 #pragma once
 
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string_view>
 
-template<size_t max_length>
+namespace detail {
+
+  // wyhash (final version 4), written over chars so that it can run in
+  // constant evaluation. Little-endian reads regardless of the platform.
+
+  inline constexpr std::array<std::uint64_t, 4> kWyhashSecret{
+    0x2d358dccaa6c78a5ull, 0x8bb84b93962eacc9ull, 0x4b33a62ed433d4a3ull, 0x4d5a2da51de1aa47ull};
+
+  constexpr void WyMum(std::uint64_t& a, std::uint64_t& b) noexcept {
+    const unsigned __int128 r = static_cast<unsigned __int128>(a) * b;
+    a = static_cast<std::uint64_t>(r);
+    b = static_cast<std::uint64_t>(r >> 64);
+  }
+
+  constexpr std::uint64_t WyMix(std::uint64_t a, std::uint64_t b) noexcept {
+    WyMum(a, b);
+    return a ^ b;
+  }
+
+  constexpr std::uint64_t WyRead(const char* p, std::size_t bytes) noexcept {
+    std::uint64_t value = 0;
+    for (std::size_t i = 0; i < bytes; ++i) {
+      value |= static_cast<std::uint64_t>(static_cast<unsigned char>(p[i])) << (8 * i);
+    }
+    return value;
+  }
+
+  constexpr std::uint64_t WyRead3(const char* p, std::size_t k) noexcept {
+    return (WyRead(p, 1) << 16) | (WyRead(p + (k >> 1), 1) << 8) | WyRead(p + k - 1, 1);
+  }
+
+  constexpr std::uint64_t Wyhash(std::string_view key, std::uint64_t seed = 0) noexcept {
+    const auto& secret = kWyhashSecret;
+    const char* p = key.data();
+    const std::size_t len = key.size();
+    seed ^= WyMix(seed ^ secret[0], secret[1]);
+    std::uint64_t a = 0;
+    std::uint64_t b = 0;
+    if (len <= 16) {
+      if (len >= 4) {
+        a = (WyRead(p, 4) << 32) | WyRead(p + ((len >> 3) << 2), 4);
+        b = (WyRead(p + len - 4, 4) << 32) | WyRead(p + len - 4 - ((len >> 3) << 2), 4);
+      } else if (len > 0) {
+        a = WyRead3(p, len);
+      }
+    } else {
+      std::size_t i = len;
+      if (i > 48) {
+        std::uint64_t see1 = seed;
+        std::uint64_t see2 = seed;
+        do {
+          seed = WyMix(WyRead(p, 8) ^ secret[1], WyRead(p + 8, 8) ^ seed);
+          see1 = WyMix(WyRead(p + 16, 8) ^ secret[2], WyRead(p + 24, 8) ^ see1);
+          see2 = WyMix(WyRead(p + 32, 8) ^ secret[3], WyRead(p + 40, 8) ^ see2);
+          p += 48;
+          i -= 48;
+        } while (i > 48);
+        seed ^= see1 ^ see2;
+      }
+      while (i > 16) {
+        seed = WyMix(WyRead(p, 8) ^ secret[1], WyRead(p + 8, 8) ^ seed);
+        i -= 16;
+        p += 16;
+      }
+      a = WyRead(p + i - 16, 8);
+      b = WyRead(p + i - 8, 8);
+    }
+    a ^= secret[1];
+    b ^= seed;
+    WyMum(a, b);
+    return WyMix(a ^ secret[0] ^ len, b ^ secret[1]);
+  }
+
+}
+
+// A string of at most max_length chars stored inline. All members are
+// public, so it is a structural type and can be a template argument:
+// template <FixedString name> works with a plain literal thanks to the
+// deduction guide. The hash is computed once on construction (at compile
+// time for literals and template arguments) and equality checks it before
+// touching the characters.
+template <std::size_t max_length>
 struct FixedString {
-  FixedString(const char* string, size_t length);
-  operator std::string_view() const;
+  constexpr FixedString() = default;
+
+  // Too long a string fails constant evaluation, and throws at run time.
+  constexpr FixedString(const char* string, std::size_t length) : length(length) {
+    if (length > max_length) {
+      throw std::length_error("FixedString: string longer than max_length");
+    }
+    std::copy_n(string, length, chars.begin());
+    hash = detail::Wyhash(*this);
+  }
 
-  // std::string impl; ???
+  template <std::size_t n>
+  requires (n - 1 <= max_length)
+  constexpr FixedString(const char (&literal)[n]) : FixedString(literal, n - 1) {}
+
+  constexpr operator std::string_view() const {
+    return std::string_view(chars.data(), length);
+  }
+
+  constexpr const char* Data() const noexcept {
+    return chars.data();
+  }
+
+  constexpr std::size_t Size() const noexcept {
+    return length;
+  }
+
+  constexpr std::uint64_t Hash() const noexcept {
+    return hash;
+  }
+
+  template <std::size_t other_length>
+  constexpr bool operator==(const FixedString<other_length>& other) const noexcept {
+    return hash == other.hash && std::string_view(*this) == std::string_view(other);
+  }
+
+  constexpr bool operator==(std::string_view other) const noexcept {
+    return std::string_view(*this) == other;
+  }
+
+  template <std::size_t other_length>
+  constexpr auto operator<=>(const FixedString<other_length>& other) const noexcept {
+    return std::string_view(*this) <=> std::string_view(other);
+  }
+
+  std::array<char, max_length> chars{};
+  std::size_t length = 0;
+  std::uint64_t hash = detail::Wyhash({});
 };
 
-// operator ""_cstr ?
+template <std::size_t n>
+FixedString(const char (&)[n]) -> FixedString<n - 1>;
+
+constexpr FixedString<256> operator""_cstr(const char* string, std::size_t length) {
+  return FixedString<256>(string, length);
+}
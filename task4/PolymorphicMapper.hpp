@@ -1,12 +1,164 @@
 #pragma once
 
+#include <array>
+#include <cassert>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
 #include <optional>
+#include <ranges>
+#include <type_traits>
+#include <typeinfo>
+
+#include <type_tuples.hpp>
 
 
 template <class From, auto target>
-struct Mapping;
+struct Mapping {
+  using Source = From;
+  static constexpr auto kTarget = target;
+};
+
+namespace detail {
+
+  // Per-thread memo from a dynamic type to the mapping chosen for it. Keys
+  // are type_info addresses: one type may own several type_info objects
+  // across shared libraries, which only costs an extra entry. When the
+  // table is full, lookups fall back to resolving every time.
+  template <class Mapper>
+  class DispatchCache {
+  public:
+    static constexpr std::size_t kSlots = 128;
+    static constexpr std::size_t kProbes = 8;
+
+    static DispatchCache& Local() {
+      thread_local DispatchCache cache;
+      return cache;
+    }
 
+    template <class Resolve>
+    std::size_t Lookup(const std::type_info& type, Resolve&& resolve) {
+      const std::size_t home = (reinterpret_cast<std::uintptr_t>(&type) >> 4) % kSlots;
+      for (std::size_t probe = 0; probe < kProbes; ++probe) {
+        const std::size_t slot = (home + probe) % kSlots;
+        if (keys_[slot] == &type) {
+          return values_[slot];
+        }
+        if (keys_[slot] == nullptr) {
+          const std::size_t value = resolve();
+          keys_[slot] = &type;
+          values_[slot] = value;
+          return value;
+        }
+      }
+      return resolve();
+    }
+
+  private:
+    std::array<const std::type_info*, kSlots> keys_{};
+    std::array<std::size_t, kSlots> values_{};
+  };
+
+}
+
+// map(object) is the target of the mapping whose class is the most derived
+// among those `object` is an instance of. The mappings are ordered at
+// compile time so that a class comes before all of its bases; the first
+// dynamic_cast that succeeds in that order is then the answer. The answer
+// only depends on the dynamic type, so it is resolved once per type and
+// thread and looked up by typeid afterwards.
 template <class Base, class Target, class... Mappings>
 struct PolymorphicMapper {
-  static std::optional<Target> map(const Base& object);
+  static std::optional<Target> map(const Base& object) {
+    const std::size_t index = Resolve(object);
+    if (index == kNone) {
+      return std::nullopt;
+    }
+    return kTargets[index];
+  }
+
+  // map() over a whole range of object pointers, writing to the matching
+  // positions of `out`; null pointers map to nullopt. Objects are taken
+  // per dynamic type: the mapping is resolved once for each type in the
+  // batch and reused for the following objects of the same type, and
+  // consecutive objects of one type skip even the type lookup.
+  template <std::ranges::input_range Objects, std::ranges::random_access_range Out>
+  requires std::convertible_to<std::ranges::range_reference_t<Objects>, const Base*> &&
+    std::assignable_from<std::ranges::range_reference_t<Out>, std::optional<Target>>
+  static void map_all(Objects&& objects, Out&& out) {
+    auto& cache = Cache::Local();
+    const std::type_info* last_type = nullptr;
+    std::size_t last_index = kNone;
+    auto target = std::ranges::begin(out);
+    for (const Base* object : objects) {
+      assert(target != std::ranges::end(out));
+      if (object == nullptr) {
+        *target++ = std::nullopt;
+        continue;
+      }
+      const std::type_info& type = typeid(*object);
+      if (&type != last_type) {
+        last_type = &type;
+        last_index = cache.Lookup(type, [&] { return ResolveByCasts(*object); });
+      }
+      *target++ = last_index == kNone ? std::optional<Target>() : std::optional<Target>(kTargets[last_index]);
+    }
+  }
+
+private:
+  using Cache = detail::DispatchCache<PolymorphicMapper>;
+  using Tuple = type_tuples::TTuple<Mappings...>;
+
+  static constexpr std::size_t kNone = sizeof...(Mappings);
+
+  // Minus the number of mapped classes a mapping's class derives from:
+  // sorting by it puts every class before its bases.
+  template <class M>
+  struct DerivationKey {
+    static constexpr std::ptrdiff_t Value =
+      -static_cast<std::ptrdiff_t>((0 + ... + std::is_base_of_v<typename Mappings::Source, typename M::Source>));
+  };
+
+  static constexpr std::array<Target, sizeof...(Mappings)> kTargets{static_cast<Target>(Mappings::kTarget)...};
+
+  template <class Sorted>
+  struct Chain;
+
+  template <class... Sorted>
+  struct Chain<type_tuples::TTuple<Sorted...>> {
+    static std::size_t Resolve(const Base& object) {
+      std::size_t index = kNone;
+      ((IsInstance<typename Sorted::Source>(object) && (index = IndexOf<Sorted>(), true)) || ...);
+      return index;
+    }
+  };
+
+  template <class Class>
+  static bool IsInstance(const Base& object) {
+    if constexpr (std::is_base_of_v<Class, Base>) {
+      return true;
+    } else {
+      return dynamic_cast<const Class*>(&object) != nullptr;
+    }
+  }
+
+  template <class M>
+  static constexpr std::size_t IndexOf() {
+    constexpr std::array<bool, sizeof...(Mappings)> kSame{std::is_same_v<M, Mappings>...};
+    std::size_t index = 0;
+    while (!kSame[index]) {
+      ++index;
+    }
+    return index;
+  }
+
+  // The cast chain alone, without the per-type memo.
+  static std::size_t ResolveByCasts(const Base& object) {
+    return Chain<type_tuples::SortBy<DerivationKey, Tuple>>::Resolve(object);
+  }
+
+  static std::size_t Resolve(const Base& object) {
+    return Cache::Local().Lookup(typeid(object), [&] { return ResolveByCasts(object); });
+  }
 };
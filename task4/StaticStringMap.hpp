@@ -0,0 +1,222 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <utility>
+
+#include <FixedString.hpp>
+
+// Maps from a fixed set of string keys, built at compile time around a
+// minimal perfect hash (hash and displace). Keys are spread over buckets
+// by their wyhash; each bucket, largest first, gets the smallest
+// displacement that sends all its keys to free slots of an N-slot table.
+// A lookup is then one hash, one displacement read, one slot probe and
+// one verifying compare, with nothing allocated.
+
+namespace detail {
+
+  // Maps a 64-bit value onto [0, n) with a multiply instead of a division.
+  constexpr std::size_t FastRange(std::uint64_t value, std::size_t n) noexcept {
+    return static_cast<std::size_t>((static_cast<unsigned __int128>(value) * n) >> 64);
+  }
+
+  constexpr std::size_t PerfectSlot(std::uint64_t hash, std::uint32_t displacement, std::size_t n) noexcept {
+    return FastRange(WyMix(hash ^ displacement, kWyhashSecret[2]), n);
+  }
+
+  template <std::size_t n>
+  struct PerfectHash {
+    static constexpr std::size_t kBuckets = n == 0 ? 1 : n;
+
+    constexpr std::size_t Slot(std::uint64_t hash) const noexcept {
+      return PerfectSlot(hash, displacements[FastRange(hash, kBuckets)], n);
+    }
+
+    std::array<std::uint32_t, kBuckets> displacements{};
+  };
+
+  // Fails constant evaluation on keys with equal hashes (in practice,
+  // duplicate keys), which no displacement can separate.
+  template <std::size_t n>
+  constexpr PerfectHash<n> BuildPerfectHash(const std::array<std::uint64_t, n>& hashes) {
+    constexpr std::size_t kBuckets = PerfectHash<n>::kBuckets;
+
+    std::array<std::size_t, kBuckets> sizes{};
+    std::array<std::size_t, n> bucket_of{};
+    for (std::size_t i = 0; i < n; ++i) {
+      bucket_of[i] = FastRange(hashes[i], kBuckets);
+      ++sizes[bucket_of[i]];
+    }
+
+    // Key indices grouped by bucket, and buckets ordered largest first,
+    // both with a counting sort, so every key is visited a constant number
+    // of times outside the displacement search.
+    std::array<std::size_t, kBuckets + 1> starts{};
+    for (std::size_t bucket = 0; bucket < kBuckets; ++bucket) {
+      starts[bucket + 1] = starts[bucket] + sizes[bucket];
+    }
+    std::array<std::size_t, n> by_bucket{};
+    std::array<std::size_t, kBuckets> filled{};
+    for (std::size_t i = 0; i < n; ++i) {
+      by_bucket[starts[bucket_of[i]] + filled[bucket_of[i]]++] = i;
+    }
+
+    std::array<std::size_t, n + 2> size_starts{};
+    for (std::size_t bucket = 0; bucket < kBuckets; ++bucket) {
+      ++size_starts[n - sizes[bucket] + 1];
+    }
+    for (std::size_t rank = 1; rank < size_starts.size(); ++rank) {
+      size_starts[rank] += size_starts[rank - 1];
+    }
+    std::array<std::size_t, kBuckets> bucket_order{};
+    for (std::size_t bucket = 0; bucket < kBuckets; ++bucket) {
+      bucket_order[size_starts[n - sizes[bucket]]++] = bucket;
+    }
+
+    PerfectHash<n> result;
+    std::array<bool, n> taken{};
+    std::array<std::size_t, n> slots{};
+    for (const std::size_t bucket : bucket_order) {
+      const std::size_t count = sizes[bucket];
+      if (count == 0) {
+        break;
+      }
+      const std::size_t* members = by_bucket.data() + starts[bucket];
+      for (std::size_t k = 0; k < count; ++k) {
+        for (std::size_t j = 0; j < k; ++j) {
+          if (hashes[members[j]] == hashes[members[k]]) {
+            throw "duplicate keys in a perfect hash";
+          }
+        }
+      }
+      for (std::uint32_t displacement = 0;; ++displacement) {
+        bool fits = true;
+        for (std::size_t k = 0; k < count && fits; ++k) {
+          slots[k] = PerfectSlot(hashes[members[k]], displacement, n);
+          fits = !taken[slots[k]];
+          for (std::size_t j = 0; j < k && fits; ++j) {
+            fits = slots[j] != slots[k];
+          }
+        }
+        if (fits) {
+          for (std::size_t k = 0; k < count; ++k) {
+            taken[slots[k]] = true;
+          }
+          result.displacements[bucket] = displacement;
+          break;
+        }
+      }
+    }
+    return result;
+  }
+
+}
+
+template <class Value, std::size_t n, std::size_t max_length = 64>
+class StaticStringMap {
+public:
+  using Entry = std::pair<std::string_view, Value>;
+
+  // An empty map; there is no array of zero entries to build it from, and
+  // the array constructor is a template so that none is ever named.
+  constexpr StaticStringMap() requires (n == 0) = default;
+
+  template <std::size_t count>
+  requires (count == n)
+  constexpr StaticStringMap(const Entry (&entries)[count]) {
+    std::array<std::uint64_t, n> hashes{};
+    for (std::size_t i = 0; i < n; ++i) {
+      hashes[i] = detail::Wyhash(entries[i].first);
+    }
+    hash_ = detail::BuildPerfectHash(hashes);
+    for (std::size_t i = 0; i < n; ++i) {
+      const std::size_t slot = hash_.Slot(hashes[i]);
+      keys_[slot] = FixedString<max_length>(entries[i].first.data(), entries[i].first.size());
+      values_[slot] = entries[i].second;
+    }
+  }
+
+  static constexpr std::size_t Size() noexcept {
+    return n;
+  }
+
+  // Pointer to the value of `key`, or nullptr when it is not a key.
+  constexpr const Value* Find(std::string_view key) const noexcept {
+    if constexpr (n == 0) {
+      return nullptr;
+    } else {
+      const std::uint64_t hash = detail::Wyhash(key);
+      const std::size_t slot = hash_.Slot(hash);
+      if (keys_[slot].Hash() != hash || std::string_view(keys_[slot]) != key) {
+        return nullptr;
+      }
+      return &values_[slot];
+    }
+  }
+
+  constexpr bool Contains(std::string_view key) const noexcept {
+    return Find(key) != nullptr;
+  }
+
+private:
+  detail::PerfectHash<n> hash_;
+  std::array<FixedString<max_length>, n> keys_{};
+  std::array<Value, n> values_{};
+};
+
+// A switch over strings: Index(key) is the position of key among `keys`,
+// or kNone, and kCase<key> is the same position as a constant for the
+// case labels. Unknown case labels do not compile.
+//
+//   using Verb = StringSwitch<"GET", "PUT">;
+//   switch (Verb::Index(s)) { case Verb::kCase<"GET">: ... }
+template <FixedString... keys>
+struct StringSwitch {
+  static constexpr std::size_t kNone = sizeof...(keys);
+
+  static constexpr std::size_t Index(std::string_view key) noexcept {
+    if constexpr (sizeof...(keys) == 0) {
+      return kNone;
+    } else {
+      const std::uint64_t hash = detail::Wyhash(key);
+      const std::size_t slot = kHash.Slot(hash);
+      if (kTable.hashes[slot] != hash || kTable.names[slot] != key) {
+        return kNone;
+      }
+      return kTable.positions[slot];
+    }
+  }
+
+  template <FixedString key>
+  static constexpr std::size_t kCase = [] {
+    const std::size_t index = Index(key);
+    if (index == kNone) {
+      throw "not one of the keys of this StringSwitch";
+    }
+    return index;
+  }();
+
+private:
+  static constexpr std::size_t kCount = sizeof...(keys);
+  static constexpr std::array<std::uint64_t, kCount> kByPosition{keys.Hash()...};
+  static constexpr detail::PerfectHash<kCount> kHash = detail::BuildPerfectHash(kByPosition);
+
+  // Template parameter objects have static storage, so the views into the
+  // keys stay valid.
+  struct Table {
+    std::array<std::uint64_t, kCount> hashes{};
+    std::array<std::string_view, kCount> names{};
+    std::array<std::size_t, kCount> positions{};
+  };
+
+  static constexpr Table kTable = [] {
+    Table table;
+    std::size_t position = 0;
+    ((table.hashes[kHash.Slot(keys.Hash())] = keys.Hash(),
+      table.names[kHash.Slot(keys.Hash())] = std::string_view(keys),
+      table.positions[kHash.Slot(keys.Hash())] = position++), ...);
+    return table;
+  }();
+};
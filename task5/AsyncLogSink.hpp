@@ -0,0 +1,213 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <thread>
+#include <type_traits>
+#include <utility>
+
+// Takes logging off the instrumented thread. Spies get a Handle from
+// Logger(id) as their logger; at the end of an expression it only pushes
+// a LogEvent into a bounded lock-free ring, and a background thread
+// drains the ring in batches into the real logger. The real logger runs
+// on that thread alone, so it needs no locking of its own.
+//
+//   AsyncLogSink sink([](std::span<const LogEvent> events) { ... });
+//   spy.setLogger(sink.Logger(42));
+//
+// The sink has to outlive every Spy logging into it.
+
+struct LogEvent {
+  std::uint64_t object_id;
+  std::uint64_t timestamp_ns;  // steady_clock
+  unsigned int count;
+};
+
+enum class Overflow {
+  kDrop,        // a full ring loses the event
+  kCountDrops,  // the same, and Dropped() counts them
+  kBlock,       // the producer waits for room
+};
+
+namespace detail {
+
+  // Bounded multi-producer ring in the style of Vyukov's queue: each cell
+  // carries a sequence number telling producers and the consumer whose
+  // turn it is, so a push is one CAS on the tail plus two stores. Only one
+  // thread may pop. The cells live on the heap; a ring is too big for a
+  // stack.
+  template <class T, std::size_t capacity>
+  class MpscRing {
+    static_assert(std::has_single_bit(capacity), "capacity must be a power of two");
+
+  public:
+    MpscRing() : cells_(std::make_unique<Cell[]>(capacity)) {
+      for (std::size_t i = 0; i < capacity; ++i) {
+        cells_[i].sequence.store(i, std::memory_order_relaxed);
+      }
+    }
+
+    bool TryPush(const T& value) noexcept {
+      std::size_t position = tail_.load(std::memory_order_relaxed);
+      for (;;) {
+        Cell& cell = cells_[position & kMask];
+        const std::size_t sequence = cell.sequence.load(std::memory_order_acquire);
+        const auto lag = static_cast<std::ptrdiff_t>(sequence - position);
+        if (lag == 0) {
+          if (tail_.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+            cell.value = value;
+            cell.sequence.store(position + 1, std::memory_order_release);
+            return true;
+          }
+        } else if (lag < 0) {
+          return false;
+        } else {
+          position = tail_.load(std::memory_order_relaxed);
+        }
+      }
+    }
+
+    // Consumer only. Pops up to out.size() values, returns how many.
+    std::size_t PopBatch(std::span<T> out) noexcept {
+      std::size_t position = head_.load(std::memory_order_relaxed);
+      std::size_t popped = 0;
+      for (; popped < out.size(); ++popped, ++position) {
+        Cell& cell = cells_[position & kMask];
+        if (cell.sequence.load(std::memory_order_acquire) != position + 1) {
+          break;
+        }
+        out[popped] = cell.value;
+        cell.sequence.store(position + capacity, std::memory_order_release);
+      }
+      head_.store(position, std::memory_order_release);
+      return popped;
+    }
+
+    // Pushes claimed so far, and pops completed so far.
+    std::size_t Pushed() const noexcept { return tail_.load(std::memory_order_acquire); }
+    std::size_t Popped() const noexcept { return head_.load(std::memory_order_acquire); }
+
+  private:
+    static constexpr std::size_t kMask = capacity - 1;
+
+    struct Cell {
+      std::atomic<std::size_t> sequence;
+      T value;
+    };
+
+    alignas(64) std::atomic<std::size_t> tail_{0};
+    alignas(64) std::atomic<std::size_t> head_{0};
+    std::unique_ptr<Cell[]> cells_;
+  };
+
+}
+
+template <class RealLogger, std::size_t capacity = 4096, Overflow overflow = Overflow::kCountDrops>
+requires std::invocable<RealLogger&, std::span<const LogEvent>>
+class AsyncLogSink {
+public:
+  static constexpr std::size_t kBatchSize = 256;
+
+  // What a Spy holds: two words, trivially copyable, so it stays inline.
+  class Handle {
+  public:
+    void operator()(unsigned int count) const {
+      sink_->Push(LogEvent{id_, Now(), count});
+    }
+
+  private:
+    friend AsyncLogSink;
+    Handle(AsyncLogSink* sink, std::uint64_t id) : sink_(sink), id_(id) {}
+
+    AsyncLogSink* sink_;
+    std::uint64_t id_;
+  };
+
+  explicit AsyncLogSink(RealLogger logger)
+  : logger_(std::move(logger)), consumer_([this] { Drain(); })
+  {}
+
+  AsyncLogSink(const AsyncLogSink&) = delete;
+  AsyncLogSink& operator=(const AsyncLogSink&) = delete;
+
+  // Delivers what is still in the ring, then stops the consumer.
+  ~AsyncLogSink() {
+    stop_.store(true, std::memory_order_release);
+    consumer_.join();
+  }
+
+  Handle Logger(std::uint64_t object_id) { return Handle(this, object_id); }
+
+  void Push(const LogEvent& event) {
+    if constexpr (overflow == Overflow::kBlock) {
+      while (!ring_.TryPush(event)) {
+        std::this_thread::yield();
+      }
+    } else if (!ring_.TryPush(event)) {
+      if constexpr (overflow == Overflow::kCountDrops) {
+        dropped_.fetch_add(1, std::memory_order_relaxed);
+      }
+    }
+  }
+
+  // Waits until every event pushed before the call reached the logger.
+  void Flush() const {
+    const std::size_t target = ring_.Pushed();
+    while (delivered_.load(std::memory_order_acquire) < target) {
+      std::this_thread::yield();
+    }
+  }
+
+  std::uint64_t Dropped() const
+  requires (overflow == Overflow::kCountDrops)
+  {
+    return dropped_.load(std::memory_order_relaxed);
+  }
+
+private:
+  static constexpr int kSpinsBeforeSleep = 64;
+  static constexpr std::chrono::microseconds kIdleSleep{200};
+
+  static std::uint64_t Now() noexcept {
+    return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now().time_since_epoch()).count());
+  }
+
+  void Drain() {
+    std::array<LogEvent, kBatchSize> batch;
+    int idle = 0;
+    for (;;) {
+      const bool stopping = stop_.load(std::memory_order_acquire);
+      const std::size_t popped = ring_.PopBatch(batch);
+      if (popped != 0) {
+        logger_(std::span<const LogEvent>(batch.data(), popped));
+        delivered_.store(ring_.Popped(), std::memory_order_release);
+        idle = 0;
+        continue;
+      }
+      if (stopping) {
+        return;
+      }
+      if (++idle < kSpinsBeforeSleep) {
+        std::this_thread::yield();
+      } else {
+        std::this_thread::sleep_for(kIdleSleep);
+      }
+    }
+  }
+
+  detail::MpscRing<LogEvent, capacity> ring_;
+  // Producers write dropped_ and the consumer writes delivered_ after
+  // every batch, so the two sit on separate cache lines.
+  alignas(64) std::atomic<std::uint64_t> dropped_{0};
+  alignas(64) std::atomic<std::size_t> delivered_{0};
+  std::atomic<bool> stop_{false};
+  RealLogger logger_;
+  std::thread consumer_;
+};
@@ -1,5 +1,15 @@
 #pragma once
+#include <array>
+#include <atomic>
+#include <cassert>
 #include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <new>
+#include <optional>
+#include <type_traits>
 #include <unistd.h>
 #include <variant>
 #include <utility>
@@ -8,103 +18,331 @@
 template <bool From, bool To>
 concept Implies = !From || To;
 
+// TriviallyRelocatable<T> -- opt-in: moving a T to a new address and
+// ending the old one may be done with a plain byte copy. Specialize it for
+// your own types; it is also answered for Spy below, for containers that
+// relocate by memcpy.
+
+template <class T>
+struct TriviallyRelocatable : std::is_trivially_copyable<T> {};
+
+template <class U>
+struct TriviallyRelocatable<std::allocator<U>> : std::true_type {};
+
+// Counters count the accesses of one expression: start() is called by
+// Spy::operator->, increment() by every Proxy::operator-> and finish() by
+// every ~Proxy, the first of which gets the count to log. total() is the
+// number of accesses over the Spy's lifetime.
+
 struct PointerCounter {
-  void reset() { 
-    count_ = 0; 
-    expr_finished_ = false; 
+  using Expression = PointerCounter*;
+
+  Expression start() {
+    if (expr_finished_)
+      reset();
+    return this;
+  }
+
+  static void increment(Expression expression) {
+    ++expression->count_;
+    ++expression->total_;
+  }
+
+  static std::optional<unsigned int> finish(Expression expression) {
+    if (std::exchange(expression->expr_finished_, true))
+      return std::nullopt;
+    return expression->count_;
+  }
+
+  std::uint64_t total() const { return total_; }
+
+  void reset() {
+    count_ = 0;
+    expr_finished_ = false;
   }
   unsigned int count_ = 0;
   bool expr_finished_ = false;
+  std::uint64_t total_ = 0;
+};
+
+// For a Spy used from several threads at once. Each thread keeps the state
+// of its own current expression, so expressions are logged per thread and
+// never mix counts. The lifetime total is split over cache-line-sized
+// shards, one per thread modulo kShards, bumped with relaxed atomics and
+// summed on demand. The logger may then be called from several threads
+// and has to be thread-safe itself.
+struct ConcurrentCounter {
+  static constexpr std::size_t kShards = 8;
+  // Spies with an expression in flight on one thread at the same time
+  // that are tracked without allocating; more spill to a per-thread deque.
+  static constexpr std::size_t kExpressionsPerThread = 16;
+
+  struct State {
+    const ConcurrentCounter* owner = nullptr;
+    unsigned int count_ = 0;
+    bool expr_finished_ = true;
+  };
+
+  struct Expression {
+    ConcurrentCounter* counter;
+    State* state;
+  };
+
+  ConcurrentCounter() = default;
+
+  // Copies carry the total over; expressions in flight stay with the
+  // original.
+  ConcurrentCounter(const ConcurrentCounter& other) noexcept {
+    shards_[0].value.store(other.total(), std::memory_order_relaxed);
+  }
+
+  ConcurrentCounter& operator=(const ConcurrentCounter& other) noexcept {
+    const std::uint64_t total = other.total();
+    for (auto& shard : shards_)
+      shard.value.store(0, std::memory_order_relaxed);
+    shards_[0].value.store(total, std::memory_order_relaxed);
+    return *this;
+  }
+
+  Expression start() {
+    State* state = local_state();
+    if (state->expr_finished_) {
+      state->count_ = 0;
+      state->expr_finished_ = false;
+    }
+    return {this, state};
+  }
+
+  static void increment(Expression expression) {
+    ++expression.state->count_;
+    expression.counter->shards_[shard_index()].value.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  static std::optional<unsigned int> finish(Expression expression) {
+    if (std::exchange(expression.state->expr_finished_, true))
+      return std::nullopt;
+    return expression.state->count_;
+  }
+
+  std::uint64_t total() const {
+    std::uint64_t sum = 0;
+    for (const auto& shard : shards_)
+      sum += shard.value.load(std::memory_order_relaxed);
+    return sum;
+  }
+
+  // Expression state lives with the threads that use the Spy.
+  void reset() {}
+
+private:
+  struct alignas(64) Shard {
+    std::atomic<std::uint64_t> value{0};
+  };
+
+  static std::size_t shard_index() {
+    static std::atomic<std::size_t> next_thread{0};
+    thread_local const std::size_t index = next_thread.fetch_add(1, std::memory_order_relaxed) % kShards;
+    return index;
+  }
+
+  // This thread's expression on this counter; finished slots are free to
+  // be taken by any counter. A deque keeps the spilled states in place
+  // while it grows.
+  State* local_state() {
+    thread_local std::array<State, kExpressionsPerThread> states;
+    thread_local std::deque<State> spilled;
+    State* free = nullptr;
+    auto scan = [&](auto& table) -> State* {
+      for (State& state : table) {
+        if (state.owner == this)
+          return &state;
+        if (free == nullptr && state.expr_finished_)
+          free = &state;
+      }
+      return nullptr;
+    };
+    if (State* own = scan(states))
+      return own;
+    if (State* own = scan(spilled))
+      return own;
+    if (free == nullptr)
+      free = &spilled.emplace_back();
+    free->owner = this;
+    return free;
+  }
+
+  std::array<Shard, kShards> shards_;
 };
 
+// Type-erased logger. Small loggers are built right inside the owning Spy
+// (kLoggerBufferSize bytes), larger ones come from the Spy's allocator;
+// each Storage knows which of the two it is and cleans up accordingly.
+// A Spy that is itself trivially relocatable only keeps trivially
+// relocatable loggers inline, so its bytes can be moved as they are.
+
+inline constexpr std::size_t kLoggerBufferSize = 48;
+
+template <class Allocator>
 struct IStorage {
   virtual void operator()(unsigned int) = 0;
-  virtual IStorage* self_copy() = 0;
-  virtual ~IStorage() = default;
+  virtual IStorage* copy_to(std::byte* buffer, Allocator& allocator) const = 0;
+  virtual IStorage* move_to(std::byte* buffer, Allocator& allocator) = 0;
+  virtual void destroy(Allocator& allocator) noexcept = 0;
+  virtual bool is_inline() const noexcept = 0;
+  // Inline loggers only: move into `buffer` and end this one.
+  virtual void relocate_to(std::byte* buffer) noexcept = 0;
+
+protected:
+  ~IStorage() = default;
 };
 
-template<class F>
-struct Storage : IStorage
+template <class F, class Allocator, bool relocatable = false>
+struct Storage final : IStorage<Allocator>
 {
+  using Traits = typename std::allocator_traits<Allocator>::template rebind_traits<Storage>;
+
+  template <class... Args>
+  explicit Storage(Args&&... args) : f(std::forward<Args>(args)...) {}
+
+  static constexpr bool fits_inline() {
+    return sizeof(Storage) <= kLoggerBufferSize && alignof(Storage) <= alignof(std::max_align_t) &&
+      std::is_nothrow_move_constructible_v<F> && (!relocatable || TriviallyRelocatable<F>::value);
+  }
+
+  template <class... Args>
+  static IStorage<Allocator>* create(std::byte* buffer, Allocator& allocator, Args&&... args) {
+    if constexpr (fits_inline()) {
+      return ::new (static_cast<void*>(buffer)) Storage(std::forward<Args>(args)...);
+    } else {
+      typename Traits::allocator_type storage_allocator(allocator);
+      Storage* storage = std::to_address(Traits::allocate(storage_allocator, 1));
+      try {
+        Traits::construct(storage_allocator, storage, std::forward<Args>(args)...);
+      } catch (...) {
+        Traits::deallocate(storage_allocator, storage, 1);
+        throw;
+      }
+      return storage;
+    }
+  }
+
   void operator()(unsigned int args) override { return f(args); };
-  IStorage* self_copy() override {
-    return new Storage<F>{std::forward<F>(f)};
+
+  IStorage<Allocator>* copy_to(std::byte* buffer, Allocator& allocator) const override {
+    if constexpr (std::copy_constructible<F>) {
+      return create(buffer, allocator, f);
+    } else {
+      // Spy is only copyable when its loggers are.
+      std::terminate();
+    }
+  }
+
+  IStorage<Allocator>* move_to(std::byte* buffer, Allocator& allocator) override {
+    return create(buffer, allocator, std::move(f));
+  }
+
+  bool is_inline() const noexcept override { return fits_inline(); }
+
+  void relocate_to(std::byte* buffer) noexcept override {
+    if constexpr (fits_inline()) {
+      ::new (static_cast<void*>(buffer)) Storage(std::move(f));
+      this->~Storage();
+    } else {
+      std::terminate();
+    }
+  }
+
+  void destroy(Allocator& allocator) noexcept override {
+    if constexpr (fits_inline()) {
+      this->~Storage();
+    } else {
+      typename Traits::allocator_type storage_allocator(allocator);
+      Traits::destroy(storage_allocator, this);
+      Traits::deallocate(storage_allocator, this, 1);
+    }
   }
-  Storage(F &&other_f) : f{std::move(other_f)} {}
-  ~Storage() override = default;
 
   F f;
 };
 
-template <class T> /*, class Allocator = std::allocator<std::byte>*/ 
+template <class T, class Allocator = std::allocator<std::byte>, class Counter = PointerCounter>
 class Spy 
 {
+  using AllocatorTraits = std::allocator_traits<Allocator>;
+
+  // Matches TriviallyRelocatable<Spy> below.
+  static constexpr bool kRelocatable =
+    TriviallyRelocatable<T>::value && TriviallyRelocatable<Allocator>::value && TriviallyRelocatable<Counter>::value;
+
+  static constexpr bool kStealsOnMoveAssignment =
+    AllocatorTraits::propagate_on_container_move_assignment::value || AllocatorTraits::is_always_equal::value;
 
   template <class U>
   class Proxy 
   {
     public:
-      Proxy(Spy<U>* spy) : spy_{spy} {}
+      Proxy(Spy* spy, typename Counter::Expression expression) : spy_{spy}, expression_{expression} {}
       
       U* operator->() {
-        ++spy_->pcounter_.count_;
+        Counter::increment(expression_);
         return &(spy_->value_);
       }
 
       ~Proxy() {
-        if (spy_->logger_ != nullptr && !(spy_->pcounter_.expr_finished_)) {
-          (*spy_->logger_)(spy_->pcounter_.count_);
+        const auto count = Counter::finish(expression_);
+        if (count && spy_->has_logger()) {
+          (*spy_->logger())(*count);
         }
-        spy_->pcounter_.expr_finished_ = true;
       }
 
     private:
-      Spy<U>* spy_;
+      Spy* spy_;
+      typename Counter::Expression expression_;
   };
 
 public:
   // default constructor
   Spy() = default;
 
+  explicit Spy(const Allocator& allocator)
+  : allocator_(allocator)
+  {}
+
   // copy construction
-  Spy(const T& value)
+  Spy(const T& value, const Allocator& allocator = Allocator())
   requires std::copyable<T>
-  : value_(value)
+  : value_(value), allocator_(allocator)
   {}
 
   // move construction
-  Spy(T&& value) 
+  Spy(T&& value, const Allocator& allocator = Allocator()) 
   requires std::movable<T>
-  : value_{std::move(value)} 
+  : value_{std::move(value)}, allocator_(allocator)
   {}
 
   // copy construction
   Spy(const Spy& other) 
   requires std::copyable<T>
-  : value_(other.value_)
+  : value_(other.value_),
+    allocator_(AllocatorTraits::select_on_container_copy_construction(other.allocator_))
   {
-
-    if (other.logger_) {
-      logger_.reset(other.logger_->self_copy());
-    } else {
-      logger_ = nullptr;
+    if (other.has_logger()) {
+      adopt_logger(other.logger()->copy_to(logger_buffer_, allocator_));
     }
   }
 
   // move construction
-  Spy(Spy&& other) 
+  // The logger and the counter are taken over, never cloned.
+  Spy(Spy&& other) noexcept(std::is_nothrow_move_constructible_v<T>)
   requires std::movable<T>
-  : value_{std::move(other.value_)} 
+  : value_{std::move(other.value_)}, pcounter_(other.pcounter_), allocator_(std::move(other.allocator_))
   {
-    if (other.logger_) {
-      logger_.reset(other.logger_->self_copy());
-    } else {
-      logger_ = nullptr;
-    }
+    steal_logger(other);
+    other.pcounter_.reset();
   }
 
   //copy assignment
-  Spy<T>& operator=(const Spy<T>& other) 
+  Spy& operator=(const Spy& other) 
   requires std::copyable<T>
   {
     if (this == &other) 
@@ -112,10 +350,9 @@ public:
 
     value_ = other.value_;
 
-    if (other.logger_) {
-      logger_.reset(other.logger_->self_copy());
-    } else {
-      logger_ = nullptr;
+    reset_logger();
+    if (other.has_logger()) {
+      adopt_logger(other.logger()->copy_to(logger_buffer_, allocator_));
     }
     pcounter_.reset();
 
@@ -123,7 +360,10 @@ public:
   }
 
   //move assignment
-  Spy<T>& operator=(Spy<T>&& other) 
+  // Steals like the move constructor unless the allocators differ and do
+  // not propagate; then the logger has to be moved into our own storage.
+  Spy& operator=(Spy&& other) 
+  noexcept(std::is_nothrow_move_assignable_v<T> && kStealsOnMoveAssignment)
   requires std::movable<T>
   {
     if (this == &other) 
@@ -131,36 +371,43 @@ public:
 
     value_ = std::move(other.value_);
 
-    if (other.logger_) {
-      logger_.reset(other.logger_->self_copy());
-    } else {
-      logger_ = nullptr;
+    reset_logger();
+    if constexpr (AllocatorTraits::propagate_on_container_move_assignment::value) {
+      allocator_ = std::move(other.allocator_);
+    }
+    if (kStealsOnMoveAssignment || allocator_ == other.allocator_) {
+      steal_logger(other);
+    } else if (other.has_logger()) {
+      adopt_logger(other.logger()->move_to(logger_buffer_, allocator_));
+      other.reset_logger();
     }
 
-    pcounter_ = PointerCounter(other.pcounter_);
+    pcounter_ = other.pcounter_;
     other.pcounter_.reset(); 
     return *this;
   }
 
   Proxy<T> operator->() 
   {
-    if (pcounter_.expr_finished_)
-      pcounter_.reset();
-    return Proxy<T>(this);
+    return Proxy<T>(this, pcounter_.start());
   }
 
+  // Accesses through operator-> over the lifetime of this Spy, from all
+  // threads for a ConcurrentCounter.
+  std::uint64_t accessCount() const { return pcounter_.total(); }
+
   T& operator *() { return value_; }
   const T& operator *() const { return value_; }
 
   // equality operators
-  constexpr bool operator==(const Spy<T>& other) const
+  constexpr bool operator==(const Spy& other) const
     requires std::equality_comparable<T>
   {
     return value_ == other.value_;
   }
 
   // destructor
-  ~Spy() = default;
+  ~Spy() { reset_logger(); }
 
   /*
    * if needed (see task readme):
@@ -172,19 +419,78 @@ public:
   */
 
   // Resets logger
+  // Rvalues are moved in and copyable lvalues copied; a move-only lvalue
+  // is moved from, as it always has been.
   template <std::invocable<unsigned int> Logger> /* see task readme */
   requires (Implies<std::copyable<T>, std::copyable<std::remove_reference_t<Logger>>>) && 
             (Implies<std::movable<T>, std::movable<std::remove_reference_t<Logger>>>)
   void setLogger(Logger&& other_logger)
   {
-    logger_.reset(new Storage<std::remove_cvref_t<Logger>>{std::forward<std::remove_reference_t<Logger>>(other_logger)});
+    using Stored = std::remove_cvref_t<Logger>;
+    using Argument = std::conditional_t<std::copy_constructible<Stored>, Logger&&, std::remove_reference_t<Logger>&&>;
+    reset_logger();
+    adopt_logger(Storage<Stored, Allocator, kRelocatable>::create(
+      logger_buffer_, allocator_, static_cast<Argument>(other_logger)));
   }
+
+  Allocator get_allocator() const { return allocator_; }
+
 private:
+  // An inline logger is found through the buffer rather than a stored
+  // pointer, so a Spy holds no pointer into itself.
+  bool has_logger() const noexcept {
+    return logger_inline_ || logger_ != nullptr;
+  }
+
+  IStorage<Allocator>* logger() noexcept {
+    if (logger_inline_) {
+      return std::launder(reinterpret_cast<IStorage<Allocator>*>(logger_buffer_));
+    }
+    return logger_;
+  }
+
+  const IStorage<Allocator>* logger() const noexcept {
+    return const_cast<Spy*>(this)->logger();
+  }
+
+  void adopt_logger(IStorage<Allocator>* storage) noexcept {
+    if (storage->is_inline()) {
+      assert(static_cast<void*>(storage) == static_cast<void*>(logger_buffer_));
+      logger_inline_ = true;
+    } else {
+      logger_ = storage;
+    }
+  }
+
+  // Both allocators must be able to free each other's memory.
+  void steal_logger(Spy& other) noexcept {
+    if (other.logger_inline_) {
+      other.logger()->relocate_to(logger_buffer_);
+      logger_inline_ = true;
+      other.logger_inline_ = false;
+    } else {
+      logger_ = std::exchange(other.logger_, nullptr);
+    }
+  }
+
+  void reset_logger() noexcept {
+    if (has_logger()) {
+      logger()->destroy(allocator_);
+      logger_ = nullptr;
+      logger_inline_ = false;
+    }
+  }
 
   T value_;
-  PointerCounter pcounter_; 
+  Counter pcounter_; 
 
-  std::unique_ptr<IStorage> logger_{nullptr};
+  IStorage<Allocator>* logger_ = nullptr;
+  bool logger_inline_ = false;
+  alignas(std::max_align_t) std::byte logger_buffer_[kLoggerBufferSize];
+  [[no_unique_address]] Allocator allocator_;
+};
 
-  // Allocator allocator_;
-};
\ No newline at end of file
+template <class T, class Allocator, class Counter>
+struct TriviallyRelocatable<Spy<T, Allocator, Counter>>
+  : std::bool_constant<TriviallyRelocatable<T>::value && TriviallyRelocatable<Allocator>::value &&
+                       TriviallyRelocatable<Counter>::value> {};